@@ -0,0 +1,294 @@
+#ifndef BENCH_UTIL_H
+#define BENCH_UTIL_H
+
+// Utilitários compartilhados pelos benchmarks: diretório temporário de trabalho,
+// geração de arquivos de teste, silenciamento dos logs e um proxy TCP que
+// adiciona atraso fixo em cada sentido para simular RTT em loopback.
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <csignal>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Log.h"
+#include "NeighborInfo.h"
+
+namespace bench {
+
+using Clock = std::chrono::steady_clock;
+
+inline double secondsSince(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// Processos que hospedam peers ignoram SIGPIPE, como o main do peer: o envio de
+// blocos com sendfile não aceita MSG_NOSIGNAL
+inline void ignoreSigpipe() {
+    std::signal(SIGPIPE, SIG_IGN);
+}
+
+// Cria um diretório temporário e muda o diretório corrente para ele,
+// já que o Peer grava blocks/, metadata/ e downloads/ em caminhos relativos.
+class TempWorkspace {
+public:
+    TempWorkspace() : previous(std::filesystem::current_path()) {
+        char pattern[] = "/tmp/p2p_bench_XXXXXX";
+        if (!mkdtemp(pattern)) {
+            throw std::runtime_error("Não foi possível criar diretório temporário");
+        }
+        path = pattern;
+        std::filesystem::current_path(path);
+    }
+
+    ~TempWorkspace() {
+        std::error_code ec;
+        std::filesystem::current_path(previous, ec);
+        std::filesystem::remove_all(path, ec);
+    }
+
+    const std::filesystem::path& root() const { return path; }
+
+private:
+    std::filesystem::path previous;
+    std::filesystem::path path;
+};
+
+// Lista separada por vírgulas: "1,2,4"
+inline std::vector<std::size_t> parseList(const std::string& text) {
+    std::vector<std::size_t> values;
+    std::stringstream stream(text);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        values.push_back(static_cast<std::size_t>(std::stoul(item)));
+    }
+    return values;
+}
+
+inline void writeRandomFile(const std::string& fileName, std::size_t size, unsigned seed = 42) {
+    std::mt19937_64 rng(seed);
+    std::vector<std::uint64_t> chunk(8192);
+    std::ofstream output(fileName, std::ios::binary | std::ios::trunc);
+    std::size_t written = 0;
+    while (written < size) {
+        for (auto& word : chunk) {
+            word = rng();
+        }
+        std::size_t bytes = std::min(size - written, chunk.size() * sizeof(std::uint64_t));
+        output.write(reinterpret_cast<const char*>(chunk.data()), static_cast<std::streamsize>(bytes));
+        written += bytes;
+    }
+}
+
+// Descarta a saída de std::cout/std::cerr e os logs abaixo de Error enquanto estiver em escopo
+class SilenceStdStreams {
+public:
+    SilenceStdStreams()
+        : oldOut(std::cout.rdbuf(sink.rdbuf())), oldErr(std::cerr.rdbuf(sink.rdbuf())), oldLevel(Log::level()) {
+        Log::setLevel(Log::Level::Error);
+    }
+    ~SilenceStdStreams() {
+        std::cout.rdbuf(oldOut);
+        std::cerr.rdbuf(oldErr);
+        Log::setLevel(oldLevel);
+    }
+
+private:
+    std::ostringstream sink;
+    std::streambuf* oldOut;
+    std::streambuf* oldErr;
+    Log::Level oldLevel;
+};
+
+inline bool waitUntil(const std::function<bool()>& predicate, std::chrono::milliseconds timeout) {
+    auto deadline = Clock::now() + timeout;
+    while (!predicate()) {
+        if (Clock::now() >= deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+// Proxy TCP que entrega cada trecho lido somente após oneWayDelay.
+// Não limita banda: vários trechos podem estar "no fio" ao mesmo tempo,
+// como em um enlace real de alta latência.
+class DelayProxy {
+public:
+    DelayProxy(int listenPort, NeighborInfo upstream, std::chrono::microseconds oneWayDelay)
+        : upstream(std::move(upstream)), delay(oneWayDelay) {
+        listenSock = socket(AF_INET, SOCK_STREAM, 0);
+        int opt = 1;
+        setsockopt(listenSock, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = htons(listenPort);
+        if (bind(listenSock, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 ||
+            listen(listenSock, 64) < 0) {
+            close(listenSock);
+            throw std::runtime_error("DelayProxy: falha ao escutar na porta " + std::to_string(listenPort));
+        }
+        acceptThread = std::thread(&DelayProxy::acceptLoop, this);
+    }
+
+    ~DelayProxy() {
+        stop();
+    }
+
+    void stop() {
+        if (stopped.exchange(true)) {
+            return;
+        }
+        shutdown(listenSock, SHUT_RDWR);
+        acceptThread.join();
+        close(listenSock);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (int sockfd : sockets) {
+                shutdown(sockfd, SHUT_RDWR);
+            }
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        for (int sockfd : sockets) {
+            close(sockfd);
+        }
+    }
+
+private:
+    struct Chunk {
+        Clock::time_point due;
+        std::vector<char> bytes;  // vazio sinaliza fim do fluxo
+    };
+
+    struct Direction {
+        std::mutex mutex;
+        std::condition_variable ready;
+        std::deque<Chunk> queue;
+    };
+
+    NeighborInfo upstream;
+    std::chrono::microseconds delay;
+    int listenSock = -1;
+    std::atomic<bool> stopped { false };
+    std::thread acceptThread;
+    std::mutex mutex;
+    std::vector<int> sockets;
+    std::vector<std::thread> workers;
+    std::vector<std::unique_ptr<Direction>> directions;
+
+    static int connectUpstream(const NeighborInfo& target) {
+        int sockfd = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(target.port);
+        inet_pton(AF_INET, target.ip.c_str(), &addr.sin_addr);
+        if (connect(sockfd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+            close(sockfd);
+            return -1;
+        }
+        return sockfd;
+    }
+
+    void acceptLoop() {
+        while (!stopped) {
+            int clientSock = accept(listenSock, nullptr, nullptr);
+            if (clientSock < 0) {
+                if (stopped) break;
+                continue;
+            }
+            int serverSock = connectUpstream(upstream);
+            if (serverSock < 0) {
+                close(clientSock);
+                continue;
+            }
+            int opt = 1;
+            setsockopt(clientSock, IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt));
+            setsockopt(serverSock, IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt));
+
+            std::lock_guard<std::mutex> lock(mutex);
+            sockets.push_back(clientSock);
+            sockets.push_back(serverSock);
+            startDirection(clientSock, serverSock);
+            startDirection(serverSock, clientSock);
+        }
+    }
+
+    void startDirection(int from, int to) {
+        directions.push_back(std::make_unique<Direction>());
+        Direction* direction = directions.back().get();
+        workers.emplace_back([this, from, direction] { readSide(from, *direction); });
+        workers.emplace_back([to, direction] { writeSide(to, *direction); });
+    }
+
+    void readSide(int from, Direction& direction) {
+        std::vector<char> buffer(64 * 1024);
+        while (true) {
+            ssize_t readBytes = ::read(from, buffer.data(), buffer.size());
+            Chunk chunk{Clock::now() + delay, {}};
+            if (readBytes > 0) {
+                chunk.bytes.assign(buffer.begin(), buffer.begin() + readBytes);
+            }
+            {
+                std::lock_guard<std::mutex> lock(direction.mutex);
+                direction.queue.push_back(std::move(chunk));
+            }
+            direction.ready.notify_one();
+            if (readBytes <= 0) {
+                return;
+            }
+        }
+    }
+
+    static void writeSide(int to, Direction& direction) {
+        while (true) {
+            Chunk chunk;
+            {
+                std::unique_lock<std::mutex> lock(direction.mutex);
+                direction.ready.wait(lock, [&direction] { return !direction.queue.empty(); });
+                chunk = std::move(direction.queue.front());
+                direction.queue.pop_front();
+            }
+            if (chunk.bytes.empty()) {
+                shutdown(to, SHUT_WR);
+                return;
+            }
+            std::this_thread::sleep_until(chunk.due);
+            std::size_t sent = 0;
+            while (sent < chunk.bytes.size()) {
+                ssize_t written = ::send(to, chunk.bytes.data() + sent, chunk.bytes.size() - sent, MSG_NOSIGNAL);
+                if (written <= 0) {
+                    break;
+                }
+                sent += static_cast<std::size_t>(written);
+            }
+        }
+    }
+};
+
+} // namespace bench
+
+#endif
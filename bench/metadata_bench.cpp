@@ -0,0 +1,67 @@
+// Benchmark: tempo até a metadata (FileProcessor::createFileMetadata) em função
+// do tamanho do arquivo e do número de threads. Cada configuração deve gerar
+// exatamente o mesmo checksum e a mesma raiz de Merkle da versão com 1 thread.
+// O arquivo é lido uma vez antes das medições, então o page cache está quente:
+// o resultado mede o custo de CPU (hash), não o do disco.
+//
+// Uso: metadata_bench [--sizes-mb 16,64,256] [--threads 1,2,4,8] [--block B] [--with-blocks]
+
+#include "BenchUtil.h"
+#include "FileProcessor.h"
+
+#include <cstdio>
+
+int main(int argc, char* argv[]) {
+    std::vector<std::size_t> sizesMb = {16, 64, 256};
+    std::vector<std::size_t> threadCounts = {1, 2, 4, std::max(1u, std::thread::hardware_concurrency())};
+    std::size_t blockSize = 256 * 1024;
+    bool withBlocks = false;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--with-blocks") withBlocks = true;
+        else if (i + 1 >= argc) break;
+        else if (arg == "--sizes-mb") sizesMb = bench::parseList(argv[++i]);
+        else if (arg == "--threads") threadCounts = bench::parseList(argv[++i]);
+        else if (arg == "--block") blockSize = std::stoul(argv[++i]);
+    }
+
+    bench::TempWorkspace workspace;
+    std::printf("# metadata_bench: blocos de %zu B, %u núcleo(s), block files %s\n",
+                blockSize, std::thread::hardware_concurrency(), withBlocks ? "sim" : "não");
+    std::printf("%-10s %8s %10s %10s %10s %s\n", "tamanho_MB", "threads", "tempo_s", "MB/s", "speedup", "confere");
+
+    bool allMatch = true;
+    for (std::size_t sizeMb : sizesMb) {
+        bench::writeRandomFile("payload.bin", sizeMb * 1024 * 1024);
+        FileProcessor::computeFileChecksum("payload.bin"); // aquece o page cache
+
+        std::string referenceChecksum;
+        std::string referenceRoot;
+        double baseline = 0.0;
+        for (std::size_t threads : threadCounts) {
+            FileProcessor::MetadataOptions options;
+            options.threads = static_cast<unsigned>(threads);
+            options.writeBlockFiles = withBlocks;
+
+            auto start = bench::Clock::now();
+            auto result = FileProcessor::createFileMetadata("payload.bin", blockSize, options);
+            double elapsed = bench::secondsSince(start);
+
+            if (referenceChecksum.empty()) {
+                referenceChecksum = result.content.info.checksum;
+                referenceRoot = result.content.info.merkleRoot;
+                baseline = elapsed;
+            }
+            bool match = result.content.info.checksum == referenceChecksum &&
+                         result.content.info.merkleRoot == referenceRoot;
+            allMatch = allMatch && match;
+
+            std::printf("%-10zu %8zu %10.3f %10.1f %10.2f %s\n", sizeMb, threads, elapsed,
+                        static_cast<double>(sizeMb) / elapsed, baseline / elapsed, match ? "ok" : "DIVERGENTE");
+        }
+        std::filesystem::remove_all("blocks");
+    }
+
+    return allMatch ? 0 : 1;
+}
@@ -0,0 +1,282 @@
+// Microbenchmarks dos núcleos quentes, medidos isoladamente:
+// - Protocol: sendMessage + receiveMessage de um frame por um socketpair
+// - Sha256: update + finalize de mensagens de vários tamanhos
+// - metadata: leitura de um .meta local, parse e serialização nos formatos binário e texto
+// - DownloadScheduler: um download inteiro (acquire/deliver/complete de cada bloco)
+//
+// Cada caso é calibrado para que uma repetição dure ao menos --min-ms; depois de
+// --warmup repetições descartadas, mede --reps repetições e reporta a mediana em
+// ns por operação (e MB/s quando faz sentido). --save-baseline grava os
+// resultados; --baseline compara com um arquivo gravado antes e termina com erro
+// se algum caso ficou mais lento que --tolerance por cento.
+//
+// Uso: micro_bench [--filter texto] [--reps R] [--warmup W] [--min-ms M]
+//                  [--baseline arquivo] [--save-baseline arquivo] [--tolerance P]
+
+#include "BenchUtil.h"
+#include "DownloadScheduler.h"
+#include "FileProcessor.h"
+#include "Protocol.h"
+#include "Sha256.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <map>
+#include <sys/socket.h>
+
+namespace {
+
+struct Case {
+    std::string name;
+    // Bytes processados por operação (0: não reporta vazão)
+    std::size_t bytesPerOp;
+    std::function<void(std::size_t iterations)> run;
+};
+
+struct Result {
+    double medianNs;
+    double minNs;
+};
+
+// Impede o compilador de descartar resultados não usados
+volatile unsigned char sink;
+
+double nsPerOp(const Case& benchCase, std::size_t iterations) {
+    auto start = bench::Clock::now();
+    benchCase.run(iterations);
+    return bench::secondsSince(start) * 1e9 / static_cast<double>(iterations);
+}
+
+Result measure(const Case& benchCase, int reps, int warmup, double minMs) {
+    // Dobra as iterações até uma repetição durar o mínimo (serve de aquecimento)
+    std::size_t iterations = 1;
+    while (nsPerOp(benchCase, iterations) * static_cast<double>(iterations) < minMs * 1e6) {
+        iterations *= 2;
+    }
+    for (int i = 0; i < warmup; ++i) {
+        nsPerOp(benchCase, iterations);
+    }
+    std::vector<double> samples;
+    for (int i = 0; i < reps; ++i) {
+        samples.push_back(nsPerOp(benchCase, iterations));
+    }
+    std::sort(samples.begin(), samples.end());
+    return Result{samples[samples.size() / 2], samples.front()};
+}
+
+std::map<std::string, double> loadBaseline(const std::string& path) {
+    std::map<std::string, double> baseline;
+    std::ifstream input(path);
+    if (!input) {
+        throw std::runtime_error("Não foi possível abrir a baseline " + path);
+    }
+    std::string line;
+    while (std::getline(input, line)) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        std::istringstream fields(line);
+        std::string name;
+        double ns = 0.0;
+        if (fields >> name >> ns) {
+            baseline[name] = ns;
+        }
+    }
+    return baseline;
+}
+
+// Um frame de `size` bytes vai e volta pelo mesmo socketpair: mede a
+// codificação, o writev e a leitura do cabeçalho e do payload
+Case protocolCase(int sockets[2], std::size_t size) {
+    auto payload = std::make_shared<std::vector<std::uint8_t>>(size, 0x5a);
+    auto received = std::make_shared<Protocol::ReceiveBuffer>();
+    return Case{"protocol/roundtrip_" + std::to_string(size), size,
+                [sockets, payload, received](std::size_t iterations) {
+                    Protocol::PayloadPart part{payload->data(), payload->size()};
+                    Protocol::MessageType type;
+                    for (std::size_t i = 0; i < iterations; ++i) {
+                        if (!Protocol::sendMessage(sockets[0], Protocol::MessageType::BLOCK_DATA, &part, 1) ||
+                            !Protocol::receiveMessage(sockets[1], type, *received)) {
+                            throw std::runtime_error("falha no socketpair");
+                        }
+                    }
+                    sink = received->data()[0];
+                }};
+}
+
+Case sha256Case(std::size_t size) {
+    auto data = std::make_shared<std::vector<unsigned char>>(size, 0xa5);
+    return Case{"sha256/update_" + std::to_string(size), size, [data](std::size_t iterations) {
+                    for (std::size_t i = 0; i < iterations; ++i) {
+                        Sha256 hasher;
+                        hasher.update(data->data(), data->size());
+                        sink = hasher.finalize()[0];
+                    }
+                }};
+}
+
+// Quatro vizinhos com o arquivo inteiro; os workers pedem em rodízio até o fim.
+// O custo por bloco deve ficar constante quando o número de blocos cresce.
+Case schedulerCase(std::size_t blocks) {
+    constexpr std::size_t workers = 4;
+    auto bitfield = std::make_shared<std::vector<std::uint8_t>>((blocks + 7) / 8, 0xff);
+    auto scheduler = std::make_shared<DownloadScheduler>();
+    return Case{"scheduler/download_" + std::to_string(blocks), 0,
+                [blocks, bitfield, scheduler](std::size_t iterations) {
+                    std::vector<bool> owned(blocks, false);
+                    for (std::size_t i = 0; i < iterations; ++i) {
+                        scheduler->reset(owned, workers);
+                        for (std::size_t worker = 0; worker < workers; ++worker) {
+                            scheduler->mergeBitfield(worker, bitfield->data(), bitfield->size());
+                        }
+                        for (std::size_t n = 0; n < blocks; ++n) {
+                            std::size_t worker = n % workers;
+                            int block = scheduler->acquireBlock(worker);
+                            scheduler->deliverBlock(block, worker);
+                            scheduler->completeBlock(block);
+                        }
+                        sink = static_cast<unsigned char>(scheduler->remainingBlocks());
+                    }
+                }};
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::string filter;
+    int reps = 7;
+    int warmup = 2;
+    double minMs = 20.0;
+    double tolerance = 10.0;
+    std::string baselinePath;
+    std::string savePath;
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string arg = argv[i];
+        if (arg == "--filter") filter = argv[i + 1];
+        else if (arg == "--reps") reps = std::max(1, std::stoi(argv[i + 1]));
+        else if (arg == "--warmup") warmup = std::stoi(argv[i + 1]);
+        else if (arg == "--min-ms") minMs = std::stod(argv[i + 1]);
+        else if (arg == "--tolerance") tolerance = std::stod(argv[i + 1]);
+        else if (arg == "--baseline") baselinePath = argv[i + 1];
+        else if (arg == "--save-baseline") savePath = argv[i + 1];
+    }
+
+    std::map<std::string, double> baseline;
+    if (!baselinePath.empty()) {
+        baseline = loadBaseline(baselinePath);
+    }
+    if (!savePath.empty()) {
+        savePath = std::filesystem::absolute(savePath).string();
+    }
+
+    bench::TempWorkspace workspace;
+
+    int sockets[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, sockets) < 0) {
+        std::perror("socketpair");
+        return 1;
+    }
+    // O frame inteiro cabe no socket: envio e recepção na mesma thread não bloqueiam
+    int bufferSize = 1 << 20;
+    setsockopt(sockets[0], SOL_SOCKET, SO_SNDBUF, &bufferSize, sizeof(bufferSize));
+    setsockopt(sockets[1], SOL_SOCKET, SO_RCVBUF, &bufferSize, sizeof(bufferSize));
+
+    // Metadata real: 16 MB em blocos de 4 KB (4096 hashes)
+    bench::writeRandomFile("payload.bin", 16 * 1024 * 1024);
+    auto created = FileProcessor::createFileMetadata("payload.bin", 4096);
+    auto metadata = created.content;
+    auto metadataPath = std::make_shared<std::string>(created.metadataPath);
+    auto binary = std::make_shared<std::string>(FileProcessor::serializeMetadata(metadata));
+    auto text = std::make_shared<std::string>(
+        FileProcessor::serializeMetadata(metadata, FileProcessor::MetadataFormat::Text));
+    auto content = std::make_shared<FileProcessor::MetadataContent>(metadata);
+
+    std::vector<Case> cases;
+    for (std::size_t size : {64u, 4096u, 65536u}) {
+        cases.push_back(protocolCase(sockets, size));
+    }
+    for (std::size_t size : {64u, 1024u, 16384u, 262144u}) {
+        cases.push_back(sha256Case(size));
+    }
+    cases.push_back(Case{"metadata/parse_binary", binary->size(), [binary](std::size_t iterations) {
+                             for (std::size_t i = 0; i < iterations; ++i) {
+                                 sink = static_cast<unsigned char>(
+                                     FileProcessor::parseMetadataBuffer(binary->data(), binary->size()).info.blockCount);
+                             }
+                         }});
+    // .meta local: mmap, parse sem recalcular a raiz e cópia da tabela de hashes
+    cases.push_back(Case{"metadata/load_binary", binary->size(), [metadataPath](std::size_t iterations) {
+                             for (std::size_t i = 0; i < iterations; ++i) {
+                                 sink = static_cast<unsigned char>(
+                                     FileProcessor::loadMetadataFile(*metadataPath).info.blockCount);
+                             }
+                         }});
+    cases.push_back(Case{"metadata/parse_text", text->size(), [text](std::size_t iterations) {
+                             for (std::size_t i = 0; i < iterations; ++i) {
+                                 sink = static_cast<unsigned char>(
+                                     FileProcessor::parseMetadataString(*text).info.blockCount);
+                             }
+                         }});
+    cases.push_back(Case{"metadata/serialize_binary", binary->size(), [content](std::size_t iterations) {
+                             for (std::size_t i = 0; i < iterations; ++i) {
+                                 sink = static_cast<unsigned char>(FileProcessor::serializeMetadata(*content).size());
+                             }
+                         }});
+    cases.push_back(Case{"metadata/serialize_text", text->size(), [content](std::size_t iterations) {
+                             for (std::size_t i = 0; i < iterations; ++i) {
+                                 sink = static_cast<unsigned char>(
+                                     FileProcessor::serializeMetadata(*content, FileProcessor::MetadataFormat::Text)
+                                         .size());
+                             }
+                         }});
+
+    for (std::size_t blocks : {4096u, 65536u}) {
+        cases.push_back(schedulerCase(blocks));
+    }
+
+    std::printf("# micro_bench: %d repetições (mediana), %d de aquecimento, >= %.0f ms cada\n",
+                reps, warmup, minMs);
+    std::printf("%-28s %14s %14s %10s %10s\n", "caso", "ns/op", "min_ns/op", "MB/s", "vs_base");
+
+    std::ostringstream saved;
+    saved << "# micro_bench: nome ns/op (mediana)\n";
+    bool regressed = false;
+    for (const auto& benchCase : cases) {
+        if (!filter.empty() && benchCase.name.find(filter) == std::string::npos) {
+            continue;
+        }
+        Result result = measure(benchCase, reps, warmup, minMs);
+        char throughput[32] = "-";
+        if (benchCase.bytesPerOp > 0) {
+            std::snprintf(throughput, sizeof(throughput), "%.1f",
+                          static_cast<double>(benchCase.bytesPerOp) / result.medianNs * 1e9 / 1e6);
+        }
+        char comparison[32] = "-";
+        auto reference = baseline.find(benchCase.name);
+        if (reference != baseline.end()) {
+            double change = (result.medianNs / reference->second - 1.0) * 100.0;
+            bool slower = change > tolerance;
+            regressed = regressed || slower;
+            std::snprintf(comparison, sizeof(comparison), "%+.1f%%%s", change, slower ? " !" : "");
+        }
+        std::printf("%-28s %14.1f %14.1f %10s %10s\n", benchCase.name.c_str(), result.medianNs, result.minNs,
+                    throughput, comparison);
+        std::fflush(stdout);
+        saved << benchCase.name << " " << result.medianNs << "\n";
+    }
+    close(sockets[0]);
+    close(sockets[1]);
+
+    if (!savePath.empty()) {
+        std::ofstream output(savePath, std::ios::trunc);
+        output << saved.str();
+        std::printf("# baseline gravada em %s\n", savePath.c_str());
+    }
+    if (regressed) {
+        std::printf("# regressão: casos marcados com ! ficaram mais de %.0f%% mais lentos que a baseline\n",
+                    tolerance);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,89 @@
+// Benchmark: vazão de download de um único vizinho em função da janela de
+// pipeline (PeerConfig::pipelineWindow), com atraso artificial em loopback.
+//
+// Uso: pipeline_bench [--delay-ms D] [--size-kb S] [--block B] [--windows 1,2,4,...] [--port P]
+
+#include "BenchUtil.h"
+#include "FileProcessor.h"
+#include "Peer.h"
+
+#include <cstdio>
+
+int main(int argc, char* argv[]) {
+    double delayMs = 5.0;
+    std::size_t sizeKb = 2048;
+    std::size_t blockSize = 4096;
+    std::vector<std::size_t> windows = {1, 2, 4, 8, 16, 32, 64};
+    int basePort = 7400;
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string arg = argv[i];
+        if (arg == "--delay-ms") delayMs = std::stod(argv[i + 1]);
+        else if (arg == "--size-kb") sizeKb = std::stoul(argv[i + 1]);
+        else if (arg == "--block") blockSize = std::stoul(argv[i + 1]);
+        else if (arg == "--windows") windows = bench::parseList(argv[i + 1]);
+        else if (arg == "--port") basePort = std::stoi(argv[i + 1]);
+    }
+
+    bench::ignoreSigpipe();
+    bench::TempWorkspace workspace;
+    bench::writeRandomFile("payload.bin", sizeKb * 1024);
+    auto meta = FileProcessor::createFileMetadata("payload.bin", blockSize);
+
+    std::printf("# pipeline_bench: arquivo %zu KB, blocos %zu B (%d blocos), atraso %.2f ms por sentido\n",
+                sizeKb, blockSize, meta.content.info.blockCount, delayMs);
+    std::printf("%-8s %10s %12s %12s\n", "window", "tempo_s", "MB/s", "blocos/s");
+
+    PeerConfig seederConfig;
+    seederConfig.startupDelay = std::chrono::milliseconds(0);
+    std::unique_ptr<Peer> seeder;
+    std::thread seederThread;
+    bench::DelayProxy proxy(basePort + 1, NeighborInfo{"127.0.0.1", basePort},
+                            std::chrono::microseconds(static_cast<long long>(delayMs * 1000)));
+
+    int leecherPort = basePort + 2;
+    {
+        bench::SilenceStdStreams silence;
+        seeder = std::make_unique<Peer>(basePort, std::vector<NeighborInfo>{}, meta.metadataPath, seederConfig);
+        seederThread = std::thread([&seeder] { seeder->start(); });
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+
+    for (std::size_t window : windows) {
+        PeerConfig config;
+        config.pipelineWindow = window;
+        config.startupDelay = std::chrono::milliseconds(0);
+        config.downloadRoot = "downloads_w" + std::to_string(window);
+
+        double elapsed = 0.0;
+        bool completed = false;
+        {
+            bench::SilenceStdStreams silence;
+            Peer leecher(leecherPort++, {NeighborInfo{"127.0.0.1", basePort + 1}}, "", config);
+            auto startTime = bench::Clock::now();
+            std::thread leecherThread([&leecher] { leecher.start(); });
+            completed = bench::waitUntil([&leecher] { return leecher.isDownloadComplete(); },
+                                         std::chrono::seconds(120));
+            elapsed = bench::secondsSince(startTime);
+            leecher.stop();
+            leecherThread.join();
+        }
+
+        if (!completed) {
+            std::printf("%-8zu %10s\n", window, "timeout");
+            continue;
+        }
+        double megabytes = static_cast<double>(meta.content.info.fileSize) / (1024.0 * 1024.0);
+        std::printf("%-8zu %10.3f %12.2f %12.0f\n", window, elapsed, megabytes / elapsed,
+                    meta.content.info.blockCount / elapsed);
+        std::fflush(stdout);
+    }
+
+    {
+        bench::SilenceStdStreams silence;
+        seeder->stop();
+        seederThread.join();
+        proxy.stop();
+    }
+    return 0;
+}
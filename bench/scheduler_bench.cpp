@@ -0,0 +1,114 @@
+// Benchmark: vazão agregada de um leecher em função da quantidade de seeders
+// vizinhos. Cada seeder fica atrás de um proxy com atraso, de modo que um
+// único vizinho é limitado pela latência e os demais somam banda.
+//
+// Uso: scheduler_bench [--max-neighbors N] [--delay-ms D] [--window W] [--size-kb S] [--block B] [--port P]
+
+#include "BenchUtil.h"
+#include "FileProcessor.h"
+#include "Peer.h"
+
+#include <cstdio>
+
+int main(int argc, char* argv[]) {
+    int maxNeighbors = 4;
+    double delayMs = 5.0;
+    std::size_t window = 4;
+    std::size_t sizeKb = 2048;
+    std::size_t blockSize = 4096;
+    int basePort = 7600;
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string arg = argv[i];
+        if (arg == "--max-neighbors") maxNeighbors = std::stoi(argv[i + 1]);
+        else if (arg == "--delay-ms") delayMs = std::stod(argv[i + 1]);
+        else if (arg == "--window") window = std::stoul(argv[i + 1]);
+        else if (arg == "--size-kb") sizeKb = std::stoul(argv[i + 1]);
+        else if (arg == "--block") blockSize = std::stoul(argv[i + 1]);
+        else if (arg == "--port") basePort = std::stoi(argv[i + 1]);
+    }
+
+    bench::ignoreSigpipe();
+    bench::TempWorkspace workspace;
+    bench::writeRandomFile("payload.bin", sizeKb * 1024);
+    auto meta = FileProcessor::createFileMetadata("payload.bin", blockSize);
+
+    std::printf("# scheduler_bench: arquivo %zu KB, blocos %zu B, janela %zu, atraso %.2f ms por sentido\n",
+                sizeKb, blockSize, window, delayMs);
+    std::printf("%-10s %10s %10s %10s\n", "vizinhos", "tempo_s", "MB/s", "speedup");
+
+    // Seeders e proxies são compartilhados entre as rodadas
+    std::vector<std::unique_ptr<Peer>> seeders;
+    std::vector<std::thread> seederThreads;
+    std::vector<std::unique_ptr<bench::DelayProxy>> proxies;
+    {
+        bench::SilenceStdStreams silence;
+        PeerConfig seederConfig;
+        seederConfig.startupDelay = std::chrono::milliseconds(0);
+        for (int i = 0; i < maxNeighbors; ++i) {
+            int seederPort = basePort + 2 * i;
+            seeders.push_back(std::make_unique<Peer>(seederPort, std::vector<NeighborInfo>{},
+                                                     meta.metadataPath, seederConfig));
+            Peer* seeder = seeders.back().get();
+            seederThreads.emplace_back([seeder] { seeder->start(); });
+            proxies.push_back(std::make_unique<bench::DelayProxy>(
+                seederPort + 1, NeighborInfo{"127.0.0.1", seederPort},
+                std::chrono::microseconds(static_cast<long long>(delayMs * 1000))));
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+
+    double baseline = 0.0;
+    int leecherPort = basePort + 2 * maxNeighbors;
+    for (int count = 1; count <= maxNeighbors; ++count) {
+        std::vector<NeighborInfo> neighbors;
+        for (int i = 0; i < count; ++i) {
+            neighbors.push_back(NeighborInfo{"127.0.0.1", basePort + 2 * i + 1});
+        }
+
+        PeerConfig config;
+        config.pipelineWindow = window;
+        config.startupDelay = std::chrono::milliseconds(0);
+        config.downloadRoot = "downloads_n" + std::to_string(count);
+
+        double elapsed = 0.0;
+        bool completed = false;
+        {
+            bench::SilenceStdStreams silence;
+            Peer leecher(leecherPort++, neighbors, "", config);
+            auto startTime = bench::Clock::now();
+            std::thread leecherThread([&leecher] { leecher.start(); });
+            completed = bench::waitUntil([&leecher] { return leecher.isDownloadComplete(); },
+                                         std::chrono::seconds(120));
+            elapsed = bench::secondsSince(startTime);
+            leecher.stop();
+            leecherThread.join();
+        }
+
+        if (!completed) {
+            std::printf("%-10d %10s\n", count, "timeout");
+            continue;
+        }
+        if (count == 1) {
+            baseline = elapsed;
+        }
+        double megabytes = static_cast<double>(meta.content.info.fileSize) / (1024.0 * 1024.0);
+        std::printf("%-10d %10.3f %10.2f %10.2f\n", count, elapsed, megabytes / elapsed,
+                    baseline > 0.0 ? baseline / elapsed : 0.0);
+        std::fflush(stdout);
+    }
+
+    {
+        bench::SilenceStdStreams silence;
+        for (auto& seeder : seeders) {
+            seeder->stop();
+        }
+        for (auto& thread : seederThreads) {
+            thread.join();
+        }
+        for (auto& proxy : proxies) {
+            proxy->stop();
+        }
+    }
+    return 0;
+}
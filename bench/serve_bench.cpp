@@ -0,0 +1,168 @@
+// Benchmark: custo do caminho de envio de blocos do seeder, comparando a
+// leitura para memória (cópia), a cópia servida pelo cache de blocos e o envio
+// direto do page cache (sendfile). Reporta vazão, taxa de acerto do cache e, por
+// bloco, syscalls de envio, bytes copiados em espaço de usuário e alocações de
+// memória (operator new do processo inteiro, servidor e cliente).
+//
+// Uso: serve_bench [--size-kb S] [--block B] [--passes N] [--window W] [--port P] [--cache-mb C]
+
+#include "BenchUtil.h"
+#include "ConnectionPool.h"
+#include "EventServer.h"
+#include "FileProcessor.h"
+#include "Peer.h"
+#include "Protocol.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+namespace {
+
+std::atomic<std::uint64_t> allocationCount { 0 };
+
+}
+
+void* operator new(std::size_t size) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (void* memory = std::malloc(size > 0 ? size : 1)) {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+// noinline: o GCC compara malloc/free com new/delete ao inlinear e acusa falsa divergência
+__attribute__((noinline)) void operator delete(void* memory) noexcept {
+    std::free(memory);
+}
+
+__attribute__((noinline)) void operator delete(void* memory, std::size_t) noexcept {
+    std::free(memory);
+}
+
+namespace {
+
+// Requisita todos os blocos `passes` vezes mantendo `window` pedidos pendentes
+bool fetchAllBlocks(int sockfd, int blockCount, int passes, int window) {
+    long long total = static_cast<long long>(blockCount) * passes;
+    long long sent = 0;
+    long long received = 0;
+    Protocol::MessageType type;
+    // Como no cliente do Peer: buffer de recepção reaproveitado, sem alocação por bloco
+    Protocol::ReceiveBuffer payload;
+    while (received < total) {
+        while (sent < total && sent - received < window) {
+            std::uint32_t indexNetwork = htonl(static_cast<std::uint32_t>(sent % blockCount));
+            Protocol::PayloadPart part{&indexNetwork, sizeof(indexNetwork)};
+            if (!Protocol::sendMessage(sockfd, Protocol::MessageType::REQUEST_BLOCK, &part, 1)) {
+                return false;
+            }
+            ++sent;
+        }
+        if (!Protocol::receiveMessage(sockfd, type, payload) || type != Protocol::MessageType::BLOCK_DATA) {
+            return false;
+        }
+        ++received;
+    }
+    return true;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    std::size_t sizeKb = 8192;
+    std::size_t blockSize = 16384;
+    int passes = 4;
+    int window = 32;
+    int basePort = 7500;
+    std::size_t cacheMb = 64;
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string arg = argv[i];
+        if (arg == "--size-kb") sizeKb = std::stoul(argv[i + 1]);
+        else if (arg == "--block") blockSize = std::stoul(argv[i + 1]);
+        else if (arg == "--passes") passes = std::stoi(argv[i + 1]);
+        else if (arg == "--window") window = std::stoi(argv[i + 1]);
+        else if (arg == "--port") basePort = std::stoi(argv[i + 1]);
+        else if (arg == "--cache-mb") cacheMb = std::stoul(argv[i + 1]);
+    }
+
+    bench::ignoreSigpipe();
+    bench::TempWorkspace workspace;
+    bench::writeRandomFile("payload.bin", sizeKb * 1024);
+    auto meta = FileProcessor::createFileMetadata("payload.bin", blockSize);
+    int blockCount = meta.content.info.blockCount;
+
+    std::printf("# serve_bench: arquivo %zu KB, blocos %zu B, %d passadas, janela %d\n",
+                sizeKb, blockSize, passes, window);
+    std::printf("%-12s %9s %9s %9s %12s %14s %16s %12s\n", "caminho", "tempo_s", "MB/s", "acertos",
+                "send/bloco", "sendfile/bloco", "bytes_copiados/bloco", "alocs/bloco");
+
+    struct Mode {
+        const char* name;
+        bool zeroCopy;
+        std::size_t cacheBytes;
+    };
+    const Mode modes[] = {
+        {"copia", false, 0},
+        {"copia+cache", false, cacheMb * 1024 * 1024},
+        {"sendfile", true, 0},
+    };
+
+    int port = basePort;
+    for (const Mode& mode : modes) {
+        PeerConfig config;
+        config.startupDelay = std::chrono::milliseconds(0);
+        config.zeroCopyServe = mode.zeroCopy;
+        config.blockCacheBytes = mode.cacheBytes;
+
+        double elapsed = 0.0;
+        bool ok = false;
+        EventServer::IoCounters& counters = EventServer::ioCounters();
+        std::uint64_t sendBefore = 0, sendfileBefore = 0, copiedBefore = 0;
+        std::uint64_t allocationsBefore = 0, allocations = 0;
+        BlockCache::Stats cacheBefore, cacheAfter;
+        {
+            bench::SilenceStdStreams silence;
+            Peer seeder(port, {}, meta.metadataPath, config);
+            std::thread seederThread([&seeder] { seeder.start(); });
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+            int sockfd = ConnectionPool::connectTo(NeighborInfo{"127.0.0.1", port});
+            if (sockfd >= 0) {
+                // Aquece o page cache antes de medir
+                fetchAllBlocks(sockfd, blockCount, 1, window);
+                sendBefore = counters.sendCalls;
+                sendfileBefore = counters.sendfileCalls;
+                copiedBefore = counters.copiedBytes;
+                cacheBefore = seeder.blockCacheStats();
+                allocationsBefore = allocationCount.load();
+                auto startTime = bench::Clock::now();
+                ok = fetchAllBlocks(sockfd, blockCount, passes, window);
+                elapsed = bench::secondsSince(startTime);
+                allocations = allocationCount.load() - allocationsBefore;
+                cacheAfter = seeder.blockCacheStats();
+                close(sockfd);
+            }
+            seeder.stop();
+            seederThread.join();
+        }
+        ++port;
+
+        const char* name = mode.name;
+        if (!ok) {
+            std::printf("%-12s %9s\n", name, "falhou");
+            continue;
+        }
+        std::uint64_t lookups = (cacheAfter.hits - cacheBefore.hits) + (cacheAfter.misses - cacheBefore.misses);
+        double hitRate = lookups > 0 ? 100.0 * (cacheAfter.hits - cacheBefore.hits) / lookups : 0.0;
+        double blocks = static_cast<double>(blockCount) * passes;
+        double megabytes = static_cast<double>(meta.content.info.fileSize) * passes / (1024.0 * 1024.0);
+        std::printf("%-12s %9.3f %9.1f %8.1f%% %12.2f %14.2f %16.0f %12.2f\n", name, elapsed, megabytes / elapsed, hitRate,
+                    (counters.sendCalls - sendBefore) / blocks,
+                    (counters.sendfileCalls - sendfileBefore) / blocks,
+                    (counters.copiedBytes - copiedBefore) / blocks, allocations / blocks);
+    }
+    return 0;
+}
@@ -0,0 +1,112 @@
+// Benchmark: vazão do SHA-256 (GB/s) em cada backend disponível na CPU.
+// - fluxo único: Sha256::hash sobre um buffer grande (checksum do arquivo)
+// - por bloco:   Sha256::hashMany sobre o buffer dividido em blocos (metadata)
+// Antes de medir, confere que todos os backends produzem os mesmos digests.
+//
+// Uso: sha256_bench [--size-mb M] [--block B] [--reps R]
+
+#include "BenchUtil.h"
+#include "Sha256.h"
+
+#include <cstdio>
+
+namespace {
+
+using Backend = Sha256::Backend;
+
+const Backend allBackends[] = {Backend::Scalar, Backend::ShaNi, Backend::Avx2};
+
+void hashBlocks(const std::vector<unsigned char>& data, std::size_t blockSize,
+                std::vector<Sha256::Digest>& out) {
+    std::vector<const void*> pointers;
+    std::vector<std::size_t> sizes;
+    for (std::size_t offset = 0; offset < data.size(); offset += blockSize) {
+        pointers.push_back(data.data() + offset);
+        sizes.push_back(std::min(blockSize, data.size() - offset));
+    }
+    out.resize(pointers.size());
+    Sha256::hashMany(pointers.data(), sizes.data(), out.data(), pointers.size());
+}
+
+// Melhor tempo entre as repetições, convertido em GB/s
+template <typename Fn>
+double measureGbps(std::size_t bytes, int reps, Fn&& fn) {
+    fn(); // aquecimento
+    double best = 1e30;
+    for (int i = 0; i < reps; ++i) {
+        auto start = bench::Clock::now();
+        fn();
+        best = std::min(best, bench::secondsSince(start));
+    }
+    return static_cast<double>(bytes) / best / 1e9;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::size_t sizeMb = 64;
+    std::size_t blockSize = 16 * 1024;
+    int reps = 5;
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string arg = argv[i];
+        if (arg == "--size-mb") sizeMb = std::stoul(argv[i + 1]);
+        else if (arg == "--block") blockSize = std::stoul(argv[i + 1]);
+        else if (arg == "--reps") reps = std::stoi(argv[i + 1]);
+    }
+
+    std::vector<unsigned char> data(sizeMb * 1024 * 1024);
+    std::mt19937 rng(42);
+    for (auto& byte : data) {
+        byte = static_cast<unsigned char>(rng());
+    }
+
+    Backend detected = Sha256::backend();
+    std::printf("# sha256_bench: %zu MB, blocos de %zu B, %d repetições (backend padrão: %s)\n",
+                sizeMb, blockSize, reps, Sha256::backendName(detected));
+
+    // Conferência cruzada com o escalar: tamanhos irregulares e o buffer inteiro
+    std::vector<std::size_t> crossSizes = {0, 1, 55, 56, 63, 64, 65, 127, 128, 1000, 4095, 65537};
+    std::vector<const void*> crossData(crossSizes.size(), data.data());
+    std::vector<Sha256::Digest> reference(crossSizes.size());
+    Sha256::setBackend(Backend::Scalar);
+    Sha256::hashMany(crossData.data(), crossSizes.data(), reference.data(), crossSizes.size());
+    Sha256::Digest referenceWhole = Sha256::hash(data.data(), data.size());
+
+    bool allMatch = true;
+    for (Backend backend : allBackends) {
+        if (!Sha256::setBackend(backend)) {
+            continue;
+        }
+        std::vector<Sha256::Digest> digests(crossSizes.size());
+        Sha256::hashMany(crossData.data(), crossSizes.data(), digests.data(), crossSizes.size());
+
+        Sha256 streaming;
+        for (std::size_t offset = 0; offset < data.size(); offset += 1000) {
+            streaming.update(data.data() + offset, std::min<std::size_t>(1000, data.size() - offset));
+        }
+        bool match = digests == reference && streaming.finalize() == referenceWhole &&
+                     Sha256::hash(data.data(), data.size()) == referenceWhole;
+        std::printf("# conferência %-8s %s\n", Sha256::backendName(backend), match ? "ok" : "DIVERGENTE");
+        allMatch = allMatch && match;
+    }
+
+    std::printf("%-10s %14s %14s\n", "backend", "fluxo_GB/s", "por_bloco_GB/s");
+    std::vector<Sha256::Digest> blockDigests;
+    for (Backend backend : allBackends) {
+        if (!Sha256::setBackend(backend)) {
+            std::printf("%-10s %14s %14s\n", Sha256::backendName(backend), "-", "-");
+            continue;
+        }
+        double single = measureGbps(data.size(), reps, [&] {
+            Sha256::hash(data.data(), data.size());
+        });
+        double perBlock = measureGbps(data.size(), reps, [&] {
+            hashBlocks(data, blockSize, blockDigests);
+        });
+        std::printf("%-10s %14.3f %14.3f\n", Sha256::backendName(backend), single, perBlock);
+    }
+
+    Sha256::setBackend(detected);
+    return allMatch ? 0 : 1;
+}
@@ -0,0 +1,314 @@
+// Benchmark: um enxame inteiro em um único processo, sem terminais. Lê o mesmo
+// formato de data/tests/*.conf usado por `make run`, sobe cada SEEDER e LEECHER
+// como um Peer em sua própria thread (em loopback) e mede até todos os leechers
+// terminarem. O resultado sai em JSON no stdout: tempo de cada leecher, vazão
+// agregada, bytes por vizinho e p50/p99 do RTT dos blocos (de Metrics).
+//
+// O arquivo compartilhado vem de --file (copiado para o diretório temporário) ou
+// é gerado com --size-mb; a metadata é criada com --block. Sem nenhum dos dois,
+// a metadata indicada em cada linha SEEDER é usada como está.
+//
+// --slow-port P coloca o peer da porta P (numeração do .conf) atrás de um
+// DelayProxy com --slow-ms de atraso por sentido: um vizinho lento, que segura os
+// últimos blocos sem o modo endgame. --link-ms D põe os demais peers atrás de
+// proxies com D ms, para o download durar o bastante para o vizinho lento receber
+// pedidos. --no-endgame desliga o modo nos leechers.
+//
+// Além do tempo total, cada leecher reporta tail_s: o tempo entre ter 95% dos
+// blocos e terminar, que é onde o vizinho lento pesa.
+//
+// Uso: swarm_bench --conf <arquivo.conf> [--file <arquivo> | --size-mb N] [--block B]
+//                  [--name cenário] [--port-offset N] [--window W] [--timeout-s T]
+//                  [--slow-port P] [--slow-ms D] [--link-ms D] [--no-endgame]
+
+#include "BenchUtil.h"
+#include "FileProcessor.h"
+#include "Peer.h"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace {
+
+struct PeerSpec {
+    bool seeder = false;
+    int port = 0;
+    std::string metadataPath;
+    std::vector<NeighborInfo> neighbors;
+};
+
+std::vector<PeerSpec> parseConf(const std::string& path, int portOffset) {
+    std::ifstream input(path);
+    if (!input) {
+        throw std::runtime_error("Não foi possível abrir " + path);
+    }
+    std::vector<PeerSpec> specs;
+    std::string line;
+    while (std::getline(input, line)) {
+        std::istringstream fields(line);
+        std::string role;
+        fields >> role;
+        if (role != "SEEDER" && role != "LEECHER") {
+            continue;
+        }
+        PeerSpec spec;
+        spec.seeder = role == "SEEDER";
+        fields >> spec.port;
+        spec.port += portOffset;
+        if (spec.seeder) {
+            fields >> spec.metadataPath;
+        }
+        NeighborInfo neighbor;
+        while (fields >> neighbor.ip >> neighbor.port) {
+            neighbor.port += portOffset;
+            spec.neighbors.push_back(neighbor);
+        }
+        specs.push_back(std::move(spec));
+    }
+    return specs;
+}
+
+void printHistogram(const Metrics::Histogram& histogram) {
+    std::printf("{\"count\": %llu, \"mean\": %.1f, \"p50\": %llu, \"p99\": %llu, \"max\": %llu}",
+                static_cast<unsigned long long>(histogram.count), histogram.meanMicros(),
+                static_cast<unsigned long long>(histogram.percentileMicros(0.50)),
+                static_cast<unsigned long long>(histogram.percentileMicros(0.99)),
+                static_cast<unsigned long long>(histogram.maxMicros));
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::string confPath;
+    std::string filePath;
+    std::string name;
+    std::size_t sizeMb = 0;
+    std::size_t blockSize = 4096;
+    int portOffset = 0;
+    std::size_t window = PeerConfig().pipelineWindow;
+    double timeoutSeconds = 120.0;
+    int slowPort = 0;
+    double slowMs = 50.0;
+    double linkMs = 0.0;
+    bool endgame = true;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--no-endgame") {
+            endgame = false;
+            continue;
+        }
+        if (i + 1 >= argc) break;
+        if (arg == "--conf") confPath = argv[i + 1];
+        else if (arg == "--file") filePath = argv[i + 1];
+        else if (arg == "--size-mb") sizeMb = std::stoul(argv[i + 1]);
+        else if (arg == "--block") blockSize = std::stoul(argv[i + 1]);
+        else if (arg == "--name") name = argv[i + 1];
+        else if (arg == "--port-offset") portOffset = std::stoi(argv[i + 1]);
+        else if (arg == "--window") window = std::stoul(argv[i + 1]);
+        else if (arg == "--timeout-s") timeoutSeconds = std::stod(argv[i + 1]);
+        else if (arg == "--slow-port") slowPort = std::stoi(argv[i + 1]);
+        else if (arg == "--slow-ms") slowMs = std::stod(argv[i + 1]);
+        else if (arg == "--link-ms") linkMs = std::stod(argv[i + 1]);
+        ++i;
+    }
+    if (confPath.empty()) {
+        std::fprintf(stderr, "Uso: %s --conf <arquivo.conf> [--file <arquivo> | --size-mb N] [--block B] "
+                             "[--name cenário] [--port-offset N] [--window W] [--timeout-s T] "
+                             "[--slow-port P] [--slow-ms D] [--link-ms D] [--no-endgame]\n", argv[0]);
+        return 1;
+    }
+    if (name.empty()) {
+        name = std::filesystem::path(confPath).stem().string();
+    }
+
+    // Caminhos relativos ao diretório de onde o benchmark foi chamado
+    auto specs = parseConf(confPath, portOffset);
+    namespace fs = std::filesystem;
+    std::string sourceFile = filePath.empty() ? "" : fs::absolute(filePath).string();
+    for (auto& spec : specs) {
+        if (spec.seeder && !spec.metadataPath.empty()) {
+            spec.metadataPath = fs::absolute(spec.metadataPath).string();
+        }
+    }
+
+    bench::ignoreSigpipe();
+    bench::TempWorkspace workspace;
+    Log::setLevel(Log::Level::Warn);
+
+    std::string sharedMetadata;
+    if (!sourceFile.empty() || sizeMb > 0) {
+        std::string payload = sourceFile.empty() ? "payload.bin" : fs::path(sourceFile).filename().string();
+        if (sourceFile.empty()) {
+            bench::writeRandomFile(payload, sizeMb * 1024 * 1024);
+        } else {
+            fs::copy_file(sourceFile, payload);
+        }
+        sharedMetadata = FileProcessor::createFileMetadata(payload, blockSize).metadataPath;
+    }
+
+    std::vector<std::unique_ptr<Peer>> seeders;
+    std::vector<std::unique_ptr<Peer>> leechers;
+    std::vector<int> leecherPorts;
+    std::vector<std::thread> threads;
+    std::vector<std::unique_ptr<bench::DelayProxy>> proxies;
+    FileInfo info;
+
+    // Um peer atrasado escuta em outra porta; o proxy ocupa a porta que os vizinhos conhecem
+    constexpr int proxyPortShift = 20000;
+    auto delayOf = [&](const PeerSpec& spec) {
+        return slowPort > 0 && spec.port == slowPort + portOffset ? slowMs : linkMs;
+    };
+    auto listenPort = [&](const PeerSpec& spec) {
+        return delayOf(spec) > 0 ? spec.port + proxyPortShift : spec.port;
+    };
+    for (const auto& spec : specs) {
+        if (delayOf(spec) > 0) {
+            proxies.push_back(std::make_unique<bench::DelayProxy>(
+                spec.port, NeighborInfo{"127.0.0.1", spec.port + proxyPortShift},
+                std::chrono::microseconds(static_cast<long long>(delayOf(spec) * 1000))));
+        }
+    }
+
+    for (const auto& spec : specs) {
+        if (!spec.seeder) {
+            continue;
+        }
+        std::string metadataPath = sharedMetadata.empty() ? spec.metadataPath : sharedMetadata;
+        info = FileProcessor::loadMetadataFile(metadataPath).info;
+        PeerConfig config;
+        config.startupDelay = std::chrono::milliseconds(0);
+        seeders.push_back(std::make_unique<Peer>(listenPort(spec), spec.neighbors, metadataPath, config));
+        threads.emplace_back([peer = seeders.back().get()] { peer->start(); });
+    }
+    if (seeders.empty()) {
+        std::fprintf(stderr, "%s não tem nenhum SEEDER\n", confPath.c_str());
+        return 1;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    auto startTime = bench::Clock::now();
+    for (const auto& spec : specs) {
+        if (spec.seeder) {
+            continue;
+        }
+        PeerConfig config;
+        config.pipelineWindow = window;
+        config.startupDelay = std::chrono::milliseconds(0);
+        config.retryInterval = std::chrono::milliseconds(200);
+        config.blockRetryInterval = std::chrono::milliseconds(100);
+        config.endgame = endgame;
+        config.downloadRoot = "peer_" + std::to_string(spec.port);
+        leechers.push_back(std::make_unique<Peer>(listenPort(spec), spec.neighbors, "", config));
+        leecherPorts.push_back(spec.port);
+        threads.emplace_back([peer = leechers.back().get()] { peer->start(); });
+    }
+
+    // Momento em que cada leecher terminou e em que já tinha 95% dos blocos;
+    // espera todos ou o limite de tempo
+    std::vector<double> finishedAt(leechers.size(), -1.0);
+    std::vector<double> nearlyAt(leechers.size(), -1.0);
+    auto deadline = startTime + std::chrono::duration_cast<bench::Clock::duration>(
+                                    std::chrono::duration<double>(timeoutSeconds));
+    std::size_t completed = 0;
+    while (completed < leechers.size() && bench::Clock::now() < deadline) {
+        for (std::size_t i = 0; i < leechers.size(); ++i) {
+            if (finishedAt[i] >= 0) {
+                continue;
+            }
+            if (nearlyAt[i] < 0) {
+                // Cópias descartadas no endgame não entram em BlocksFetched
+                std::uint64_t fetched = leechers[i]->metricsSnapshot().counter(Metrics::Counter::BlocksFetched);
+                if (fetched * 100 >= static_cast<std::uint64_t>(info.blockCount) * 95) {
+                    nearlyAt[i] = bench::secondsSince(startTime);
+                }
+            }
+            if (leechers[i]->isDownloadComplete()) {
+                finishedAt[i] = bench::secondsSince(startTime);
+                if (nearlyAt[i] < 0) {
+                    nearlyAt[i] = finishedAt[i];
+                }
+                ++completed;
+            }
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    double wallSeconds = bench::secondsSince(startTime);
+
+    std::vector<Metrics::Snapshot> snapshots;
+    for (const auto& leecher : leechers) {
+        snapshots.push_back(leecher->metricsSnapshot());
+    }
+    for (auto& peer : leechers) {
+        peer->stop();
+    }
+    for (auto& peer : seeders) {
+        peer->stop();
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    for (auto& proxy : proxies) {
+        proxy->stop();
+    }
+
+    std::uint64_t totalBytes = 0;
+    Metrics::Histogram allRtt;
+    double worstTail = 0.0;
+    for (std::size_t i = 0; i < leechers.size(); ++i) {
+        double finished = finishedAt[i] >= 0 ? finishedAt[i] : wallSeconds;
+        if (nearlyAt[i] >= 0) {
+            worstTail = std::max(worstTail, finished - nearlyAt[i]);
+        }
+    }
+    for (const auto& snapshot : snapshots) {
+        for (const auto& neighbor : snapshot.fetchedFrom) {
+            totalBytes += neighbor.bytes;
+        }
+        allRtt.merge(snapshot.latency(Metrics::Latency::BlockRtt));
+    }
+    constexpr double megabyte = 1024.0 * 1024.0;
+
+    std::printf("{\n  \"scenario\": \"%s\",\n  \"conf\": \"%s\",\n", name.c_str(), confPath.c_str());
+    std::printf("  \"file_bytes\": %llu,\n  \"block_size\": %d,\n  \"blocks\": %d,\n",
+                static_cast<unsigned long long>(info.fileSize), info.blockSize, info.blockCount);
+    std::printf("  \"seeders\": %zu,\n  \"leechers\": %zu,\n  \"completed\": %zu,\n  \"window\": %zu,\n",
+                seeders.size(), leechers.size(), completed, window);
+    std::printf("  \"endgame\": %s,\n  \"slow_port\": %d,\n  \"slow_ms\": %.1f,\n  \"link_ms\": %.1f,\n",
+                endgame ? "true" : "false", slowPort, slowPort > 0 ? slowMs : 0.0, linkMs);
+    std::printf("  \"wall_s\": %.3f,\n  \"tail_s\": %.3f,\n  \"aggregate_mb_s\": %.2f,\n  \"block_rtt_us\": ",
+                wallSeconds, worstTail, static_cast<double>(totalBytes) / megabyte / wallSeconds);
+    printHistogram(allRtt);
+    std::printf(",\n  \"leechers_detail\": [");
+    for (std::size_t i = 0; i < leechers.size(); ++i) {
+        const auto& snapshot = snapshots[i];
+        double seconds = finishedAt[i] >= 0 ? finishedAt[i] : wallSeconds;
+        double tail = nearlyAt[i] >= 0 ? seconds - nearlyAt[i] : 0.0;
+        std::uint64_t bytes = 0;
+        for (const auto& neighbor : snapshot.fetchedFrom) {
+            bytes += neighbor.bytes;
+        }
+        std::printf("%s\n    {\"port\": %d, \"complete\": %s, \"time_s\": %.3f, \"tail_s\": %.3f, "
+                    "\"mb_s\": %.2f, \"blocks_fetched\": %llu, \"duplicate_blocks\": %llu, \"block_rtt_us\": ",
+                    i == 0 ? "" : ",", leecherPorts[i], finishedAt[i] >= 0 ? "true" : "false", seconds, tail,
+                    static_cast<double>(bytes) / megabyte / seconds,
+                    static_cast<unsigned long long>(snapshot.counter(Metrics::Counter::BlocksFetched)),
+                    static_cast<unsigned long long>(snapshot.counter(Metrics::Counter::DuplicateBlocks)));
+        printHistogram(snapshot.latency(Metrics::Latency::BlockRtt));
+        std::printf(", \"neighbors\": [");
+        for (std::size_t j = 0; j < snapshot.fetchedFrom.size(); ++j) {
+            const auto& neighbor = snapshot.fetchedFrom[j];
+            std::printf("%s\n      {\"address\": \"%s\", \"blocks\": %llu, \"bytes\": %llu, \"errors\": %llu, "
+                        "\"rtt_p50_us\": %llu, \"rtt_p99_us\": %llu}",
+                        j == 0 ? "" : ",", neighbor.address.c_str(),
+                        static_cast<unsigned long long>(neighbor.blocks),
+                        static_cast<unsigned long long>(neighbor.bytes),
+                        static_cast<unsigned long long>(neighbor.errors),
+                        static_cast<unsigned long long>(neighbor.rtt.percentileMicros(0.50)),
+                        static_cast<unsigned long long>(neighbor.rtt.percentileMicros(0.99)));
+        }
+        std::printf("]}");
+    }
+    std::printf("\n  ]\n}\n");
+    return completed == leechers.size() ? 0 : 1;
+}
@@ -0,0 +1,76 @@
+#include "AtomicBitmap.h"
+
+void AtomicBitmap::reset(std::size_t bits, bool value) {
+    bitCount = bits;
+    wordCount = (bits + 63) / 64;
+    words = std::make_unique<std::atomic<std::uint64_t>[]>(wordCount);
+    for (std::size_t i = 0; i < wordCount; ++i) {
+        words[i].store(value ? validMask(i) : 0, std::memory_order_relaxed);
+    }
+    setCount.store(value ? bits : 0, std::memory_order_release);
+    firstOpenWord.store(value ? wordCount : 0, std::memory_order_relaxed);
+}
+
+// Bits que representam blocos na palavra (a última pode ser parcial)
+std::uint64_t AtomicBitmap::validMask(std::size_t word) const {
+    std::size_t bitsInWord = bitCount - word * 64;
+    return bitsInWord >= 64 ? ~std::uint64_t{0} : (std::uint64_t{1} << bitsInWord) - 1;
+}
+
+bool AtomicBitmap::test(std::size_t index) const {
+    if (index >= bitCount) {
+        return false;
+    }
+    std::uint64_t mask = std::uint64_t{1} << (index % 64);
+    return (words[index / 64].load(std::memory_order_acquire) & mask) != 0;
+}
+
+bool AtomicBitmap::set(std::size_t index) {
+    if (index >= bitCount) {
+        return false;
+    }
+    std::uint64_t mask = std::uint64_t{1} << (index % 64);
+    std::uint64_t previous = words[index / 64].fetch_or(mask, std::memory_order_acq_rel);
+    if (previous & mask) {
+        return false;
+    }
+    setCount.fetch_add(1, std::memory_order_acq_rel);
+    return true;
+}
+
+std::size_t AtomicBitmap::findFirstZero() const {
+    std::size_t word = firstOpenWord.load(std::memory_order_relaxed);
+    std::uint64_t missing = 0;
+    for (; word < wordCount; ++word) {
+        missing = ~words[word].load(std::memory_order_acquire) & validMask(word);
+        if (missing != 0) {
+            break;
+        }
+    }
+
+    // As palavras anteriores estão cheias e continuarão cheias
+    std::size_t known = firstOpenWord.load(std::memory_order_relaxed);
+    while (known < word && !firstOpenWord.compare_exchange_weak(known, word, std::memory_order_relaxed)) {
+    }
+
+    if (word == wordCount) {
+        return npos;
+    }
+    return word * 64 + static_cast<std::size_t>(__builtin_ctzll(missing));
+}
+
+std::vector<std::uint64_t> AtomicBitmap::snapshot() const {
+    std::vector<std::uint64_t> copy(wordCount);
+    for (std::size_t i = 0; i < wordCount; ++i) {
+        copy[i] = words[i].load(std::memory_order_acquire);
+    }
+    return copy;
+}
+
+std::vector<bool> AtomicBitmap::toVector() const {
+    std::vector<bool> bits(bitCount);
+    for (std::size_t i = 0; i < bitCount; ++i) {
+        bits[i] = test(i);
+    }
+    return bits;
+}
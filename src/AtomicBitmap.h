@@ -0,0 +1,51 @@
+#ifndef ATOMIC_BITMAP_H
+#define ATOMIC_BITMAP_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Mapa de bits concorrente com palavras atômicas de 64 bits.
+// Os bits só são ligados (um bloco obtido nunca é perdido), o que permite:
+// - test/set sem lock, de qualquer thread;
+// - contagem de bits ligados mantida a cada set, para checar completude em O(1);
+// - busca do primeiro bit desligado com count-trailing-zeros, começando pela
+//   primeira palavra que ainda tem zeros (essa posição só avança).
+// reset() não é thread-safe: deve acontecer antes de o mapa ser publicado.
+class AtomicBitmap {
+public:
+    static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+    AtomicBitmap() = default;
+
+    void reset(std::size_t bitCount, bool value);
+
+    std::size_t size() const { return bitCount; }
+    std::size_t count() const { return setCount.load(std::memory_order_acquire); }
+    bool all() const { return count() == bitCount; }
+
+    bool test(std::size_t index) const;
+    // Liga o bit; retorna true somente para a thread que o ligou
+    bool set(std::size_t index);
+
+    // Primeiro bit desligado, ou npos se todos estiverem ligados
+    std::size_t findFirstZero() const;
+
+    // Cópia das palavras (bit i em words[i / 64], posição i % 64)
+    std::vector<std::uint64_t> snapshot() const;
+    std::vector<bool> toVector() const;
+
+private:
+    std::size_t bitCount = 0;
+    std::size_t wordCount = 0;
+    std::unique_ptr<std::atomic<std::uint64_t>[]> words;
+    std::atomic<std::size_t> setCount { 0 };
+    // Nenhuma palavra antes desta tem bits desligados
+    mutable std::atomic<std::size_t> firstOpenWord { 0 };
+
+    std::uint64_t validMask(std::size_t word) const;
+};
+
+#endif
@@ -0,0 +1,47 @@
+#ifndef BINARY_METADATA_H
+#define BINARY_METADATA_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Layout do formato binário da metadata (.meta), versão 1. Todos os inteiros
+// são little-endian e os campos ficam alinhados, então o arquivo pode ser
+// mapeado com mmap e lido direto por estas estruturas, sem etapa de parsing.
+//
+//   [cabeçalho: BinaryMetadataHeader, headerSize bytes]
+//   [strings: nome do arquivo, blocks_dir, source_file; cada uma u32 tamanho + bytes]
+//   [padding até hashesOffset (múltiplo de 64)]
+//   [tabela de hashes: blockCount * 32 bytes, o hash do bloco i no índice i]
+namespace BinaryMetadata {
+
+constexpr char magic[8] = {'P', '2', 'P', 'M', 'E', 'T', 'A', '\0'};
+constexpr std::uint32_t version = 1;
+constexpr std::size_t hashTableAlignment = 64;
+
+// Bits de Header::flags
+constexpr std::uint32_t hasBlockHashes = 1u << 0;
+
+struct Header {
+    char magic[8];
+    std::uint32_t version;
+    // Versões futuras podem crescer o cabeçalho; leitores pulam o excedente
+    std::uint32_t headerSize;
+    std::uint64_t fileSize;
+    std::uint32_t blockSize;
+    std::uint32_t blockCount;
+    std::uint32_t flags;
+    std::uint32_t reserved;
+    std::uint64_t stringsOffset;
+    std::uint64_t stringsSize;
+    std::uint64_t hashesOffset;
+    std::uint8_t checksum[32];
+    std::uint8_t merkleRoot[32];
+};
+
+static_assert(sizeof(Header) == 128, "cabeçalho da metadata binária deve ter 128 bytes");
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__,
+              "o formato binário da metadata é lido diretamente da memória em little-endian");
+
+}
+
+#endif
@@ -0,0 +1,65 @@
+#include "BlockCache.h"
+
+#include <algorithm>
+
+BlockCache::BlockCache(std::size_t capacityBytes, std::size_t shards)
+    : capacity(capacityBytes),
+      shardCount(std::max<std::size_t>(shards, 1)),
+      shardCapacity(capacityBytes / std::max<std::size_t>(shards, 1)),
+      shards(std::make_unique<Shard[]>(std::max<std::size_t>(shards, 1))) {}
+
+BlockCache::Block BlockCache::find(std::uint64_t key) {
+    Shard& shard = shardFor(key);
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.index.find(key);
+        if (it != shard.index.end()) {
+            shard.order.splice(shard.order.begin(), shard.order, it->second);
+            hits.fetch_add(1, std::memory_order_relaxed);
+            return it->second->second;
+        }
+    }
+    misses.fetch_add(1, std::memory_order_relaxed);
+    return Block();
+}
+
+void BlockCache::insert(std::uint64_t key, Block block) {
+    if (!block || block.size() > shardCapacity) {
+        return;
+    }
+
+    Shard& shard = shardFor(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    if (shard.index.count(key) > 0) {
+        return; // Outra thread já leu o mesmo bloco
+    }
+
+    std::size_t size = block.size();
+    while (!shard.order.empty() && shard.bytes + size > shardCapacity) {
+        auto& oldest = shard.order.back();
+        shard.bytes -= oldest.second.size();
+        shard.index.erase(oldest.first);
+        shard.order.pop_back();
+        evictions.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    shard.order.emplace_front(key, std::move(block));
+    shard.index.emplace(key, shard.order.begin());
+    shard.bytes += size;
+    insertions.fetch_add(1, std::memory_order_relaxed);
+}
+
+BlockCache::Stats BlockCache::stats() const {
+    Stats result;
+    result.hits = hits.load(std::memory_order_relaxed);
+    result.misses = misses.load(std::memory_order_relaxed);
+    result.insertions = insertions.load(std::memory_order_relaxed);
+    result.evictions = evictions.load(std::memory_order_relaxed);
+    result.capacityBytes = capacity;
+    for (std::size_t i = 0; i < shardCount; ++i) {
+        std::lock_guard<std::mutex> lock(shards[i].mutex);
+        result.entries += shards[i].index.size();
+        result.bytes += shards[i].bytes;
+    }
+    return result;
+}
@@ -0,0 +1,70 @@
+#ifndef BLOCK_CACHE_H
+#define BLOCK_CACHE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+#include "BufferPool.h"
+
+// Cache em memória dos blocos mais pedidos, compartilhado por todas as threads
+// do servidor. Dividido em shards com lock próprio, cada um com uma lista LRU e
+// uma fatia igual do orçamento de memória, para que pedidos simultâneos de
+// blocos diferentes raramente disputem o mesmo lock.
+// Os blocos são imutáveis depois de obtidos, então o cache nunca é invalidado.
+// Cada entrada é o frame BLOCK_DATA pronto para envio, compartilhado (sem cópia)
+// com as filas de saída das conexões.
+class BlockCache {
+public:
+    using Block = PooledBuffer;
+
+    struct Stats {
+        std::uint64_t hits = 0;
+        std::uint64_t misses = 0;
+        std::uint64_t insertions = 0;
+        std::uint64_t evictions = 0;
+        std::size_t entries = 0;
+        std::size_t bytes = 0;
+        std::size_t capacityBytes = 0;
+    };
+
+    // capacityBytes 0 desliga o cache
+    explicit BlockCache(std::size_t capacityBytes = 0, std::size_t shardCount = 16);
+
+    bool enabled() const { return capacity > 0; }
+
+    // Bloco em cache ou buffer vazio (contabilizado como falha)
+    Block find(std::uint64_t key);
+    // Blocos maiores que a fatia de um shard não são guardados
+    void insert(std::uint64_t key, Block block);
+
+    Stats stats() const;
+
+private:
+    struct Shard {
+        mutable std::mutex mutex;
+        // Mais recente na frente
+        std::list<std::pair<std::uint64_t, Block>> order;
+        std::unordered_map<std::uint64_t, std::list<std::pair<std::uint64_t, Block>>::iterator> index;
+        std::size_t bytes = 0;
+    };
+
+    std::size_t capacity;
+    std::size_t shardCount;
+    std::size_t shardCapacity;
+    std::unique_ptr<Shard[]> shards;
+
+    std::atomic<std::uint64_t> hits { 0 };
+    std::atomic<std::uint64_t> misses { 0 };
+    std::atomic<std::uint64_t> insertions { 0 };
+    std::atomic<std::uint64_t> evictions { 0 };
+
+    Shard& shardFor(std::uint64_t key) const { return shards[key % shardCount]; }
+};
+
+#endif
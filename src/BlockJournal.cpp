@@ -0,0 +1,164 @@
+#include "BlockJournal.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr char journalMagic[8] = {'P', '2', 'P', 'J', 'R', 'N', 'L', '\0'};
+constexpr std::uint32_t journalVersion = 1;
+
+struct JournalHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t blockCount;
+    std::uint64_t fileSize;
+    std::uint32_t blockSize;
+    std::uint32_t reserved;
+    // Checksum do arquivo (hex), para não retomar o diário de outro conteúdo
+    char checksum[64];
+};
+
+static_assert(sizeof(JournalHeader) == 96, "cabeçalho do diário deve ter 96 bytes");
+
+JournalHeader headerFor(const FileInfo& info) {
+    JournalHeader header{};
+    std::memcpy(header.magic, journalMagic, sizeof(header.magic));
+    header.version = journalVersion;
+    header.blockCount = static_cast<std::uint32_t>(info.blockCount);
+    header.fileSize = static_cast<std::uint64_t>(info.fileSize);
+    header.blockSize = static_cast<std::uint32_t>(info.blockSize);
+    std::memcpy(header.checksum, info.checksum.data(), std::min(info.checksum.size(), sizeof(header.checksum)));
+    return header;
+}
+
+void writeAll(int fd, const void* data, std::size_t size, off_t offset) {
+    const auto* bytes = static_cast<const char*>(data);
+    std::size_t written = 0;
+    while (written < size) {
+        ssize_t result = pwrite(fd, bytes + written, size - written, offset + static_cast<off_t>(written));
+        if (result < 0 && errno == EINTR) {
+            continue;
+        }
+        if (result < 0) {
+            throw std::runtime_error(std::string("Falha ao gravar o diário de blocos: ") + std::strerror(errno));
+        }
+        written += static_cast<std::size_t>(result);
+    }
+}
+
+bool readAll(int fd, void* data, std::size_t size, off_t offset) {
+    auto* bytes = static_cast<char*>(data);
+    std::size_t done = 0;
+    while (done < size) {
+        ssize_t result = pread(fd, bytes + done, size - done, offset + static_cast<off_t>(done));
+        if (result < 0 && errno == EINTR) {
+            continue;
+        }
+        if (result <= 0) {
+            return false;
+        }
+        done += static_cast<std::size_t>(result);
+    }
+    return true;
+}
+
+}
+
+void BlockJournal::open(const std::string& path, const FileInfo& info,
+                        std::size_t batch, std::chrono::milliseconds interval) {
+    auto fd = std::make_unique<FileDescriptor>(::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644));
+    if (!fd->valid()) {
+        throw std::runtime_error("Não foi possível abrir o diário de blocos " + path + ": " + std::strerror(errno));
+    }
+
+    const std::size_t blockCount = static_cast<std::size_t>(info.blockCount);
+    const std::size_t wordCount = (blockCount + 63) / 64;
+    JournalHeader expected = headerFor(info);
+    JournalHeader existing{};
+    std::vector<std::uint64_t> stored(wordCount, 0);
+
+    bool reuse = readAll(fd->get(), &existing, sizeof(existing), 0) &&
+                 std::memcmp(&existing, &expected, sizeof(expected)) == 0 &&
+                 readAll(fd->get(), stored.data(), stored.size() * sizeof(std::uint64_t), sizeof(expected));
+
+    if (!reuse) {
+        // Diário novo (ou de outro arquivo): começa com nenhum bloco registrado
+        std::fill(stored.begin(), stored.end(), 0);
+        if (ftruncate(fd->get(), 0) < 0) {
+            throw std::runtime_error("Falha ao recriar o diário de blocos " + path + ": " + std::strerror(errno));
+        }
+        writeAll(fd->get(), &expected, sizeof(expected), 0);
+        writeAll(fd->get(), stored.data(), stored.size() * sizeof(std::uint64_t), sizeof(expected));
+        if (fdatasync(fd->get()) < 0) {
+            throw std::runtime_error("Falha ao sincronizar o diário de blocos " + path + ": " + std::strerror(errno));
+        }
+    }
+
+    recovered.assign(blockCount, false);
+    for (std::size_t i = 0; i < blockCount; ++i) {
+        recovered[i] = (stored[i / 64] >> (i % 64)) & 1;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    descriptor = std::move(fd);
+    journalPath = path;
+    words = std::move(stored);
+    pending = 0;
+    batchBlocks = std::max<std::size_t>(batch, 1);
+    batchInterval = interval;
+    lastFlush = std::chrono::steady_clock::now();
+}
+
+bool BlockJournal::record(std::size_t blockIndex) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (blockIndex / 64 >= words.size()) {
+        return false;
+    }
+    words[blockIndex / 64] |= std::uint64_t{1} << (blockIndex % 64);
+    ++pending;
+    return pending >= batchBlocks || std::chrono::steady_clock::now() - lastFlush >= batchInterval;
+}
+
+void BlockJournal::replace(const std::vector<bool>& blocks) {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::fill(words.begin(), words.end(), 0);
+    for (std::size_t i = 0; i < blocks.size() && i / 64 < words.size(); ++i) {
+        if (blocks[i]) {
+            words[i / 64] |= std::uint64_t{1} << (i % 64);
+        }
+    }
+    pending = blocks.size();
+}
+
+void BlockJournal::flush(const std::function<void()>& syncData) {
+    if (!isOpen()) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> flushLock(flushMutex);
+    std::vector<std::uint64_t> snapshot;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (pending == 0) {
+            return;
+        }
+        snapshot = words;
+        pending = 0;
+        lastFlush = std::chrono::steady_clock::now();
+    }
+
+    // A cópia é tirada antes da sincronização dos dados: todo bloco presente
+    // nela já foi gravado, então estará no disco quando o mapa for gravado
+    syncData();
+    writeAll(descriptor->get(), snapshot.data(), snapshot.size() * sizeof(std::uint64_t), sizeof(JournalHeader));
+    if (fdatasync(descriptor->get()) < 0) {
+        throw std::runtime_error("Falha ao sincronizar o diário de blocos " + journalPath + ": " +
+                                 std::strerror(errno));
+    }
+}
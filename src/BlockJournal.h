@@ -0,0 +1,61 @@
+#ifndef BLOCK_JOURNAL_H
+#define BLOCK_JOURNAL_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "FileDescriptor.h"
+#include "FileMetadata.h"
+
+// Diário de blocos de um download: um mapa de bits em disco com os blocos cujo
+// conteúdo já foi gravado e sincronizado. Permite retomar o download depois de
+// uma queda sem baixar de novo o que já estava salvo.
+//
+// Layout: cabeçalho de 96 bytes (identifica o arquivo pela metadata) seguido de
+// uma palavra little-endian de 64 bits para cada 64 blocos. Os bits só passam de
+// 0 para 1 e só são gravados depois que os dados correspondentes foram
+// sincronizados, então mesmo uma gravação parcial do mapa é consistente.
+class BlockJournal {
+public:
+    // Abre o diário do arquivo descrito por info, criando-o se não existir.
+    // Um diário de outro arquivo (cabeçalho diferente) é recomeçado do zero.
+    void open(const std::string& path, const FileInfo& info,
+              std::size_t batchBlocks, std::chrono::milliseconds batchInterval);
+    bool isOpen() const { return descriptor && descriptor->valid(); }
+
+    // Blocos registrados no disco quando o diário foi aberto
+    const std::vector<bool>& recoveredBlocks() const { return recovered; }
+
+    // Registra um bloco em memória. Retorna true quando o lote atingiu o
+    // tamanho ou a idade configurados e deve ser gravado com flush().
+    bool record(std::size_t blockIndex);
+    // Substitui todo o mapa (ex.: após reverificar os blocos no disco)
+    void replace(const std::vector<bool>& blocks);
+
+    // Grava o mapa atual. syncData é chamado antes da gravação e deve garantir
+    // que os dados dos blocos registrados já estão no disco.
+    void flush(const std::function<void()>& syncData);
+
+private:
+    std::unique_ptr<FileDescriptor> descriptor;
+    std::string journalPath;
+    std::vector<bool> recovered;
+
+    std::mutex mutex;
+    std::vector<std::uint64_t> words;
+    std::size_t pending = 0;
+    std::size_t batchBlocks = 64;
+    std::chrono::milliseconds batchInterval { 1000 };
+    std::chrono::steady_clock::time_point lastFlush;
+
+    // Serializa as gravações sem bloquear record()
+    std::mutex flushMutex;
+};
+
+#endif
@@ -0,0 +1,120 @@
+#include "BufferPool.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+PooledBuffer::PooledBuffer(const PooledBuffer& other) : slot(other.slot) {
+    if (slot) {
+        slot->references.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+PooledBuffer& PooledBuffer::operator=(PooledBuffer other) noexcept {
+    std::swap(slot, other.slot);
+    return *this;
+}
+
+void PooledBuffer::resize(std::size_t newSize) {
+    if (!slot || newSize > slot->capacity) {
+        throw std::length_error("Tamanho maior que a capacidade do buffer");
+    }
+    slot->size = newSize;
+}
+
+void PooledBuffer::release() {
+    if (slot && slot->references.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        if (slot->pool) {
+            slot->pool->release(slot);
+        } else {
+            destroy(slot);
+        }
+    }
+    slot = nullptr;
+}
+
+void PooledBuffer::destroy(Slot* slot) {
+    delete[] slot->bytes;
+    delete slot;
+}
+
+BufferPool::BufferPool(std::size_t perSlab, std::size_t maxClasses, std::size_t maxBytes)
+    : buffersPerSlab(std::max<std::size_t>(perSlab, 1)), maxClasses(maxClasses), maxBytes(maxBytes) {}
+
+BufferPool::~BufferPool() = default;
+
+PooledBuffer BufferPool::allocate(std::size_t capacity) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        ++counters.unpooled;
+    }
+    auto* slot = new PooledBuffer::Slot;
+    slot->bytes = new std::uint8_t[std::max<std::size_t>(capacity, 1)];
+    slot->capacity = capacity;
+    slot->size = capacity;
+    slot->references.store(1, std::memory_order_relaxed);
+    return PooledBuffer(slot);
+}
+
+PooledBuffer BufferPool::acquire(std::size_t capacity) {
+    std::unique_lock<std::mutex> lock(mutex);
+    auto sizeClass = std::find_if(classes.begin(), classes.end(),
+                                  [capacity](const SizeClass& c) { return c.capacity == capacity; });
+    // Um slab novo (e a classe, se for a primeira vez) só cabe dentro dos limites
+    std::size_t slabBytes = std::max<std::size_t>(capacity, 1) * buffersPerSlab;
+    bool needsSlab = sizeClass == classes.end() || !sizeClass->freeList;
+    bool fits = slabBytes / buffersPerSlab == std::max<std::size_t>(capacity, 1) &&
+                counters.bytes + slabBytes <= maxBytes &&
+                (sizeClass != classes.end() || classes.size() < maxClasses);
+    if (needsSlab && !fits) {
+        lock.unlock();
+        return allocate(capacity);
+    }
+    if (sizeClass == classes.end()) {
+        classes.push_back(SizeClass{capacity, nullptr});
+        sizeClass = classes.end() - 1;
+    }
+
+    if (!sizeClass->freeList) {
+        // Um slab: buffersPerSlab buffers contíguos, encadeados na lista livre
+        auto bytes = std::make_unique<std::uint8_t[]>(slabBytes);
+        auto slots = std::make_unique<PooledBuffer::Slot[]>(buffersPerSlab);
+        for (std::size_t i = 0; i < buffersPerSlab; ++i) {
+            slots[i].pool = this;
+            slots[i].bytes = bytes.get() + i * capacity;
+            slots[i].capacity = capacity;
+            slots[i].nextFree = i + 1 < buffersPerSlab ? &slots[i + 1] : nullptr;
+        }
+        sizeClass->freeList = &slots[0];
+        slabs.push_back(std::move(bytes));
+        slotArrays.push_back(std::move(slots));
+        ++counters.slabs;
+        counters.buffers += buffersPerSlab;
+        counters.bytes += slabBytes;
+    }
+
+    PooledBuffer::Slot* slot = sizeClass->freeList;
+    sizeClass->freeList = slot->nextFree;
+    slot->nextFree = nullptr;
+    slot->size = capacity;
+    slot->references.store(1, std::memory_order_relaxed);
+    ++counters.acquires;
+    ++counters.inUse;
+    return PooledBuffer(slot);
+}
+
+void BufferPool::release(PooledBuffer::Slot* slot) {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto& sizeClass : classes) {
+        if (sizeClass.capacity == slot->capacity) {
+            slot->nextFree = sizeClass.freeList;
+            sizeClass.freeList = slot;
+            break;
+        }
+    }
+    --counters.inUse;
+}
+
+BufferPool::Stats BufferPool::stats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return counters;
+}
@@ -0,0 +1,110 @@
+#ifndef BUFFER_POOL_H
+#define BUFFER_POOL_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+class BufferPool;
+
+// Buffer emprestado de um BufferPool, com contagem de referências: cópias
+// compartilham os mesmos bytes e a última a ser destruída devolve o buffer ao
+// pool. Permite que um bloco lido uma vez seja enfileirado em várias conexões
+// e guardado no cache sem cópias nem alocações.
+class PooledBuffer {
+public:
+    PooledBuffer() = default;
+    PooledBuffer(const PooledBuffer& other);
+    PooledBuffer(PooledBuffer&& other) noexcept : slot(other.slot) { other.slot = nullptr; }
+    PooledBuffer& operator=(PooledBuffer other) noexcept;
+    ~PooledBuffer() { release(); }
+
+    explicit operator bool() const { return slot != nullptr; }
+
+    std::uint8_t* data() { return slot->bytes; }
+    const std::uint8_t* data() const { return slot->bytes; }
+    std::size_t size() const { return slot ? slot->size : 0; }
+    std::size_t capacity() const { return slot ? slot->capacity : 0; }
+    // Ajusta o tamanho em uso, sem passar da capacidade
+    void resize(std::size_t newSize);
+
+private:
+    friend class BufferPool;
+
+    struct Slot {
+        std::atomic<std::uint32_t> references { 0 };
+        BufferPool* pool = nullptr;
+        std::uint8_t* bytes = nullptr;
+        std::size_t capacity = 0;
+        std::size_t size = 0;
+        Slot* nextFree = nullptr;
+    };
+
+    explicit PooledBuffer(Slot* slot) : slot(slot) {}
+    void release();
+    // Slot fora do pool (pool == nullptr): bytes e slot vêm do heap
+    static void destroy(Slot* slot);
+
+    Slot* slot = nullptr;
+};
+
+// Pool de buffers de tamanho fixo alocados em slabs. Cada capacidade pedida
+// forma uma classe própria, com sua lista de buffers livres; um slab novo só é
+// alocado quando ela se esgota. Só as capacidades fixas de frame de bloco
+// (cabeçalho + índice + blockSize) devem vir daqui; tamanhos avulsos usam
+// allocate(), que não fica retido.
+// Os slabs nunca voltam para o alocador, por isso o pool tem limites de classes
+// e de bytes retidos: passado algum deles, acquire() devolve um buffer do heap,
+// liberado ao ser devolvido. O pool deve viver mais que os buffers emprestados.
+class BufferPool {
+public:
+    struct Stats {
+        // Alocações de memória feitas pelo pool (slabs) e buffers criados nelas
+        std::uint64_t slabs = 0;
+        std::uint64_t buffers = 0;
+        std::uint64_t acquires = 0;
+        std::uint64_t inUse = 0;
+        // Bytes retidos nos slabs
+        std::uint64_t bytes = 0;
+        // Buffers servidos pelo heap: tamanhos avulsos ou pool no limite
+        std::uint64_t unpooled = 0;
+    };
+
+    explicit BufferPool(std::size_t buffersPerSlab = 32, std::size_t maxClasses = 8,
+                        std::size_t maxBytes = 128 * 1024 * 1024);
+    ~BufferPool();
+
+    BufferPool(const BufferPool&) = delete;
+    BufferPool& operator=(const BufferPool&) = delete;
+
+    // Buffer com size() == capacity; reaproveita um devolvido se houver
+    PooledBuffer acquire(std::size_t capacity);
+    // Buffer do heap com size() == capacity, liberado quando a última cópia é destruída
+    PooledBuffer allocate(std::size_t capacity);
+
+    Stats stats() const;
+
+private:
+    friend class PooledBuffer;
+
+    struct SizeClass {
+        std::size_t capacity = 0;
+        PooledBuffer::Slot* freeList = nullptr;
+    };
+
+    std::size_t buffersPerSlab;
+    std::size_t maxClasses;
+    std::size_t maxBytes;
+    mutable std::mutex mutex;
+    std::vector<SizeClass> classes;
+    std::vector<std::unique_ptr<std::uint8_t[]>> slabs;
+    std::vector<std::unique_ptr<PooledBuffer::Slot[]>> slotArrays;
+    Stats counters;
+
+    void release(PooledBuffer::Slot* slot);
+};
+
+#endif
@@ -0,0 +1,73 @@
+#include "ConnectionPool.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+ConnectionPool::~ConnectionPool() {
+    closeAll();
+}
+
+int ConnectionPool::acquire(const NeighborInfo& neighbor) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = idle.find(neighbor);
+        if (it != idle.end() && !it->second.empty()) {
+            int sockfd = it->second.back();
+            it->second.pop_back();
+            return sockfd;
+        }
+    }
+    return connectTo(neighbor);
+}
+
+void ConnectionPool::release(const NeighborInfo& neighbor, int sockfd) {
+    if (sockfd < 0) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    idle[neighbor].push_back(sockfd);
+}
+
+void ConnectionPool::discard(int sockfd) {
+    if (sockfd >= 0) {
+        close(sockfd);
+    }
+}
+
+void ConnectionPool::closeAll() {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto& entry : idle) {
+        for (int sockfd : entry.second) {
+            close(sockfd);
+        }
+    }
+    idle.clear();
+}
+
+int ConnectionPool::connectTo(const NeighborInfo& neighbor) {
+    int sockfd = socket(AF_INET, SOCK_STREAM, 0);
+    if (sockfd < 0) {
+        return -1;
+    }
+
+    sockaddr_in serv_addr{};
+    serv_addr.sin_family = AF_INET;
+    serv_addr.sin_port = htons(neighbor.port);
+    if (inet_pton(AF_INET, neighbor.ip.c_str(), &serv_addr.sin_addr) != 1) {
+        close(sockfd);
+        return -1;
+    }
+
+    if (connect(sockfd, (struct sockaddr *) &serv_addr, sizeof(serv_addr)) < 0) {
+        close(sockfd);
+        return -1;
+    }
+
+    // Em conexões persistentes o algoritmo de Nagle atrasaria as respostas curtas
+    int opt = 1;
+    setsockopt(sockfd, IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt));
+    return sockfd;
+}
@@ -0,0 +1,35 @@
+#ifndef CONNECTION_POOL_H
+#define CONNECTION_POOL_H
+
+#include <map>
+#include <mutex>
+#include <vector>
+
+#include "NeighborInfo.h"
+
+// Mantém conexões TCP abertas com cada vizinho para serem reutilizadas
+// entre várias mensagens, evitando um connect (e um TIME_WAIT) por bloco.
+class ConnectionPool {
+public:
+    ConnectionPool() = default;
+    ~ConnectionPool();
+
+    ConnectionPool(const ConnectionPool&) = delete;
+    ConnectionPool& operator=(const ConnectionPool&) = delete;
+
+    // Retorna uma conexão ociosa com o vizinho ou abre uma nova. -1 em caso de falha.
+    int acquire(const NeighborInfo& neighbor);
+    // Devolve ao pool uma conexão que continua utilizável.
+    void release(const NeighborInfo& neighbor, int sockfd);
+    // Fecha uma conexão que apresentou erro (não volta para o pool).
+    void discard(int sockfd);
+    void closeAll();
+
+    static int connectTo(const NeighborInfo& neighbor);
+
+private:
+    std::mutex mutex;
+    std::map<NeighborInfo, std::vector<int>> idle;
+};
+
+#endif
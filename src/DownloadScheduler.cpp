@@ -0,0 +1,256 @@
+#include "DownloadScheduler.h"
+
+#include "Protocol.h"
+
+#include <limits>
+
+void DownloadScheduler::reset(const std::vector<bool>& owned, std::size_t workerCount,
+                              std::size_t endgameBlocks) {
+    std::lock_guard<std::mutex> lock(mutex);
+    this->endgameBlocks = endgameBlocks;
+    duplicateRequests = 0;
+    states.assign(owned.size(), BlockState::MISSING);
+    unfinished.clear();
+    unfinishedPosition.assign(owned.size(), NOT_CANDIDATE);
+    for (std::size_t i = 0; i < owned.size(); ++i) {
+        if (owned[i]) {
+            states[i] = BlockState::DONE;
+        } else {
+            unfinishedPosition[i] = static_cast<std::uint32_t>(unfinished.size());
+            unfinished.push_back(static_cast<std::uint32_t>(i));
+        }
+    }
+    failedBy.assign(workerCount, std::vector<bool>(owned.size(), false));
+    available.assign(workerCount, std::vector<bool>(owned.size(), false));
+    availabilityCount.assign(owned.size(), 0);
+    requestedBy.assign(workerCount, std::vector<bool>(owned.size(), false));
+    requesters.assign(owned.size(), 0);
+    // Nenhum vizinho anunciou nada ainda: todos os baldes começam vazios
+    candidates.assign(workerCount, Candidates{});
+    for (auto& worker : candidates) {
+        worker.buckets.resize(workerCount + 1);
+        worker.position.assign(owned.size(), NOT_CANDIDATE);
+    }
+}
+
+void DownloadScheduler::removeCandidateLocked(std::size_t worker, std::size_t blockIndex) {
+    Candidates& own = candidates[worker];
+    std::uint32_t position = own.position[blockIndex];
+    if (position == NOT_CANDIDATE) {
+        return;
+    }
+    // Troca com o último do balde para remover em O(1)
+    auto& bucket = own.buckets[availabilityCount[blockIndex]];
+    std::uint32_t last = bucket.back();
+    bucket[position] = last;
+    own.position[last] = position;
+    bucket.pop_back();
+    own.position[blockIndex] = NOT_CANDIDATE;
+}
+
+void DownloadScheduler::removeCandidatesLocked(std::size_t blockIndex) {
+    for (std::size_t worker = 0; worker < candidates.size(); ++worker) {
+        removeCandidateLocked(worker, blockIndex);
+    }
+}
+
+void DownloadScheduler::refreshCandidateLocked(std::size_t worker, std::size_t blockIndex) {
+    removeCandidateLocked(worker, blockIndex);
+    if (states[blockIndex] != BlockState::MISSING || !available[worker][blockIndex] ||
+        failedBy[worker][blockIndex]) {
+        return;
+    }
+    Candidates& own = candidates[worker];
+    auto& bucket = own.buckets[availabilityCount[blockIndex]];
+    own.position[blockIndex] = static_cast<std::uint32_t>(bucket.size());
+    bucket.push_back(static_cast<std::uint32_t>(blockIndex));
+}
+
+void DownloadScheduler::refreshBlockLocked(std::size_t blockIndex) {
+    for (std::size_t worker = 0; worker < candidates.size(); ++worker) {
+        refreshCandidateLocked(worker, blockIndex);
+    }
+}
+
+void DownloadScheduler::finishBlockLocked(std::size_t blockIndex) {
+    std::uint32_t position = unfinishedPosition[blockIndex];
+    if (position == NOT_CANDIDATE) {
+        return;
+    }
+    std::uint32_t last = unfinished.back();
+    unfinished[position] = last;
+    unfinishedPosition[last] = position;
+    unfinished.pop_back();
+    unfinishedPosition[blockIndex] = NOT_CANDIDATE;
+}
+
+void DownloadScheduler::markAvailable(std::size_t worker, int blockIndex) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (blockIndex >= 0 && static_cast<std::size_t>(blockIndex) < states.size()) {
+        markAvailableLocked(worker, static_cast<std::size_t>(blockIndex));
+    }
+}
+
+void DownloadScheduler::mergeBitfield(std::size_t worker, const std::uint8_t* bits, std::size_t size) {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (std::size_t i = 0; i < states.size(); ++i) {
+        if (Protocol::bitfieldHas(bits, size, i)) {
+            markAvailableLocked(worker, i);
+        }
+    }
+}
+
+void DownloadScheduler::markAvailableLocked(std::size_t worker, std::size_t blockIndex) {
+    if (!available[worker][blockIndex]) {
+        // A contagem define o balde: o bloco sai de todos antes de ela mudar
+        removeCandidatesLocked(blockIndex);
+        available[worker][blockIndex] = true;
+        ++availabilityCount[blockIndex];
+        refreshBlockLocked(blockIndex);
+    }
+}
+
+int DownloadScheduler::acquireBlock(std::size_t worker) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    // Rarest-first: o primeiro balde não vazio tem a menor contagem de vizinhos.
+    // Empates são resolvidos por uma escolha uniforme dentro do balde.
+    for (const auto& bucket : candidates[worker].buckets) {
+        if (bucket.empty()) {
+            continue;
+        }
+        std::size_t pick = std::uniform_int_distribution<std::size_t>(0, bucket.size() - 1)(rng);
+        std::size_t chosen = bucket[pick];
+        states[chosen] = BlockState::IN_FLIGHT;
+        requestedBy[worker][chosen] = true;
+        ++requesters[chosen];
+        refreshBlockLocked(chosen);
+        return static_cast<int>(chosen);
+    }
+    return acquireDuplicateLocked(worker);
+}
+
+int DownloadScheduler::acquireDuplicateLocked(std::size_t worker) {
+    if (endgameBlocks == 0 || unfinished.size() > endgameBlocks) {
+        return -1;
+    }
+    const auto& offered = available[worker];
+    const auto& failed = failedBy[worker];
+    const auto& requested = requestedBy[worker];
+
+    // O bloco em andamento com menos pedidos: cada bloco da cauda ganha uma
+    // segunda fonte antes de algum ganhar a terceira
+    std::uint32_t fewest = std::numeric_limits<std::uint32_t>::max();
+    int chosen = -1;
+    for (std::uint32_t i : unfinished) {
+        if (states[i] != BlockState::IN_FLIGHT || !offered[i] || failed[i] || requested[i]) {
+            continue;
+        }
+        if (requesters[i] < fewest) {
+            fewest = requesters[i];
+            chosen = static_cast<int>(i);
+        }
+    }
+
+    if (chosen >= 0) {
+        requestedBy[worker][chosen] = true;
+        ++requesters[chosen];
+        ++duplicateRequests;
+    }
+    return chosen;
+}
+
+void DownloadScheduler::endRequestLocked(std::size_t blockIndex, std::size_t worker) {
+    if (requestedBy[worker][blockIndex]) {
+        requestedBy[worker][blockIndex] = false;
+        --requesters[blockIndex];
+    }
+    if (states[blockIndex] == BlockState::IN_FLIGHT && requesters[blockIndex] == 0) {
+        states[blockIndex] = BlockState::MISSING;
+        refreshBlockLocked(blockIndex);
+    }
+}
+
+bool DownloadScheduler::deliverBlock(int blockIndex, std::size_t worker) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (blockIndex < 0 || static_cast<std::size_t>(blockIndex) >= states.size()) {
+        return false;
+    }
+    endRequestLocked(static_cast<std::size_t>(blockIndex), worker);
+    if (states[blockIndex] == BlockState::RECEIVED || states[blockIndex] == BlockState::DONE) {
+        return false;
+    }
+    states[blockIndex] = BlockState::RECEIVED;
+    refreshBlockLocked(static_cast<std::size_t>(blockIndex));
+    return true;
+}
+
+void DownloadScheduler::completeBlock(int blockIndex) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (blockIndex < 0 || static_cast<std::size_t>(blockIndex) >= states.size()) {
+        return;
+    }
+    if (states[blockIndex] != BlockState::DONE) {
+        states[blockIndex] = BlockState::DONE;
+        refreshBlockLocked(static_cast<std::size_t>(blockIndex));
+        finishBlockLocked(static_cast<std::size_t>(blockIndex));
+    }
+}
+
+void DownloadScheduler::failBlock(int blockIndex, std::size_t worker) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (blockIndex < 0 || static_cast<std::size_t>(blockIndex) >= states.size()) {
+        return;
+    }
+    failedBy[worker][blockIndex] = true;
+    endRequestLocked(static_cast<std::size_t>(blockIndex), worker);
+    refreshCandidateLocked(worker, static_cast<std::size_t>(blockIndex));
+}
+
+void DownloadScheduler::rejectBlock(int blockIndex, std::size_t worker) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (blockIndex < 0 || static_cast<std::size_t>(blockIndex) >= states.size()) {
+        return;
+    }
+    failedBy[worker][blockIndex] = true;
+    // As cópias ainda pedidas a outros vizinhos continuam valendo
+    if (states[blockIndex] == BlockState::RECEIVED) {
+        states[blockIndex] = requesters[blockIndex] > 0 ? BlockState::IN_FLIGHT : BlockState::MISSING;
+    }
+    refreshBlockLocked(static_cast<std::size_t>(blockIndex));
+}
+
+void DownloadScheduler::releaseBlocks(const std::vector<int>& blocks, std::size_t worker) {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (int blockIndex : blocks) {
+        if (blockIndex >= 0 && static_cast<std::size_t>(blockIndex) < states.size()) {
+            endRequestLocked(static_cast<std::size_t>(blockIndex), worker);
+        }
+    }
+}
+
+void DownloadScheduler::clearFailures(std::size_t worker) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto& failed = failedBy[worker];
+    for (std::size_t i = 0; i < failed.size(); ++i) {
+        if (failed[i]) {
+            failed[i] = false;
+            refreshCandidateLocked(worker, i);
+        }
+    }
+}
+
+bool DownloadScheduler::isComplete() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return unfinished.empty();
+}
+
+std::size_t DownloadScheduler::remainingBlocks() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return unfinished.size();
+}
+
+std::uint64_t DownloadScheduler::endgameRequests() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return duplicateRequests;
+}
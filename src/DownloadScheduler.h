@@ -0,0 +1,105 @@
+#ifndef DOWNLOAD_SCHEDULER_H
+#define DOWNLOAD_SCHEDULER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <random>
+#include <vector>
+
+// Distribui os blocos que faltam entre os workers de cada vizinho.
+// Um bloco fica "em andamento" com um único worker por vez; quando o vizinho
+// falha em entregá-lo, o bloco volta para a fila e é oferecido primeiro aos outros.
+// Cada worker só recebe blocos que seu vizinho anunciou (BITFIELD/HAVE), escolhendo
+// primeiro os mais raros entre os vizinhos, com desempate aleatório.
+//
+// Modo endgame: quando restam no máximo endgameBlocks blocos e não há mais nenhum
+// livre para o worker, ele passa a pedir também os blocos já em andamento com
+// outros vizinhos. A primeira cópia entregue vence (deliverBlock) e as demais são
+// descartadas ao chegar, então um vizinho lento não segura os últimos blocos.
+//
+// Cada worker mantém seus candidatos (blocos livres que o vizinho possui e não
+// recusou) em baldes por contagem de disponibilidade, atualizados a cada mudança
+// de estado. acquireBlock só olha o primeiro balde não vazio: o custo depende do
+// número de vizinhos, não do número de blocos. O endgame percorre apenas os
+// blocos ainda não concluídos, que nessa fase são no máximo endgameBlocks.
+class DownloadScheduler {
+public:
+    DownloadScheduler() = default;
+
+    // Define a quantidade de blocos e de workers. owned[i] indica blocos já presentes.
+    // endgameBlocks = 0 desliga o modo endgame.
+    void reset(const std::vector<bool>& owned, std::size_t workerCount, std::size_t endgameBlocks = 0);
+
+    // Disponibilidade anunciada pelo vizinho do worker (HAVE e BITFIELD)
+    void markAvailable(std::size_t worker, int blockIndex);
+    void mergeBitfield(std::size_t worker, const std::uint8_t* bits, std::size_t size);
+
+    // Reserva o bloco mais raro que o vizinho do worker possui. -1 se não há nenhum agora.
+    // No endgame pode devolver um bloco já pedido a outro vizinho.
+    int acquireBlock(std::size_t worker);
+    // O bloco chegou pelo worker. Retorna false se outra cópia já foi entregue
+    // (duplicata do endgame, a ser descartada).
+    bool deliverBlock(int blockIndex, std::size_t worker);
+    void completeBlock(int blockIndex);
+    // O vizinho não entregou o bloco: devolve-o e evita oferecê-lo de novo ao mesmo worker
+    void failBlock(int blockIndex, std::size_t worker);
+    // O bloco entregue pelo worker foi recusado (hash divergente, falha ao gravar)
+    void rejectBlock(int blockIndex, std::size_t worker);
+    // Devolve blocos reservados por um worker cuja conexão caiu
+    void releaseBlocks(const std::vector<int>& blocks, std::size_t worker);
+    // Permite ao worker tentar novamente blocos que seu vizinho recusou antes
+    void clearFailures(std::size_t worker);
+
+    bool isComplete() const;
+    std::size_t remainingBlocks() const;
+    // Pedidos feitos a um segundo vizinho durante o endgame
+    std::uint64_t endgameRequests() const;
+
+private:
+    // RECEIVED: uma cópia chegou e está sendo verificada/gravada
+    enum class BlockState : std::uint8_t { MISSING, IN_FLIGHT, RECEIVED, DONE };
+
+    // Blocos candidatos de um worker. buckets[c] guarda os blocos que c vizinhos
+    // possuem; position[bloco] é a posição dele no seu balde (NOT_CANDIDATE se fora)
+    struct Candidates {
+        std::vector<std::vector<std::uint32_t>> buckets;
+        std::vector<std::uint32_t> position;
+    };
+    static constexpr std::uint32_t NOT_CANDIDATE = UINT32_MAX;
+
+    mutable std::mutex mutex;
+    std::vector<BlockState> states;
+    // requestedBy[worker][bloco]: o worker tem um pedido pendente do bloco
+    std::vector<std::vector<bool>> requestedBy;
+    // Quantos workers têm um pedido pendente de cada bloco
+    std::vector<std::uint32_t> requesters;
+    // failedBy[worker][bloco]: o vizinho do worker recusou ou não entregou o bloco
+    std::vector<std::vector<bool>> failedBy;
+    // available[worker][bloco]: o vizinho do worker anunciou possuir o bloco
+    std::vector<std::vector<bool>> available;
+    // Quantos vizinhos possuem cada bloco
+    std::vector<std::uint32_t> availabilityCount;
+    std::vector<Candidates> candidates;
+    // Blocos ainda não concluídos (ordem arbitrária) e a posição de cada um na lista
+    std::vector<std::uint32_t> unfinished;
+    std::vector<std::uint32_t> unfinishedPosition;
+    std::mt19937 rng { std::random_device{}() };
+    std::size_t endgameBlocks = 0;
+    std::uint64_t duplicateRequests = 0;
+
+    void markAvailableLocked(std::size_t worker, std::size_t blockIndex);
+    // Recoloca o bloco nos baldes de um worker (ou de todos) conforme o estado atual.
+    // Quem altera availabilityCount tira o bloco dos baldes antes (removeCandidatesLocked).
+    void refreshCandidateLocked(std::size_t worker, std::size_t blockIndex);
+    void refreshBlockLocked(std::size_t blockIndex);
+    void removeCandidateLocked(std::size_t worker, std::size_t blockIndex);
+    void removeCandidatesLocked(std::size_t blockIndex);
+    // Bloco concluído: sai da lista dos que faltam
+    void finishBlockLocked(std::size_t blockIndex);
+    int acquireDuplicateLocked(std::size_t worker);
+    // Encerra o pedido do worker; um bloco sem pedidos pendentes volta para a fila
+    void endRequestLocked(std::size_t blockIndex, std::size_t worker);
+};
+
+#endif
@@ -0,0 +1,448 @@
+#include "EventServer.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/sendfile.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+
+constexpr int MAX_EVENTS = 64;
+constexpr std::size_t READ_CHUNK = 64 * 1024;
+// Limites da fila de saída por conexão: acima do alto a leitura é suspensa,
+// abaixo do baixo ela volta
+constexpr std::size_t OUTBOUND_HIGH_WATER = 4 * 1024 * 1024;
+constexpr std::size_t OUTBOUND_LOW_WATER = 1024 * 1024;
+
+} // namespace
+
+void EventServer::Connection::send(Protocol::MessageType type, const std::vector<std::uint8_t>& payload) {
+    send(type, payload.data(), payload.size());
+}
+
+void EventServer::Connection::send(Protocol::MessageType type, const std::uint8_t* data, std::size_t size) {
+    Protocol::PayloadPart part{data, size};
+    send(type, &part, 1);
+}
+
+void EventServer::Connection::send(Protocol::MessageType type, const Protocol::PayloadPart* parts, std::size_t partCount) {
+    std::size_t size = 0;
+    for (std::size_t i = 0; i < partCount; ++i) {
+        size += parts[i].size;
+    }
+
+    OutboundItem item;
+    item.bytes.resize(Protocol::HEADER_SIZE + size);
+    Protocol::encodeHeader(type, static_cast<std::uint32_t>(size), item.bytes.data());
+    std::uint8_t* out = item.bytes.data() + Protocol::HEADER_SIZE;
+    for (std::size_t i = 0; i < partCount; ++i) {
+        if (parts[i].size > 0) {
+            std::memcpy(out, parts[i].data, parts[i].size);
+            out += parts[i].size;
+        }
+    }
+    EventServer::ioCounters().copiedBytes.fetch_add(size, std::memory_order_relaxed);
+    enqueue(std::move(item));
+}
+
+void EventServer::Connection::sendFile(Protocol::MessageType type, const std::uint8_t* prefix, std::size_t prefixSize,
+                                       std::shared_ptr<FileDescriptor> file, off_t offset, std::size_t length) {
+    OutboundItem item;
+    std::uint8_t* head;
+    if (Protocol::HEADER_SIZE + prefixSize <= item.shortBytes.size()) {
+        item.shortSize = Protocol::HEADER_SIZE + prefixSize;
+        head = item.shortBytes.data();
+    } else {
+        item.bytes.resize(Protocol::HEADER_SIZE + prefixSize);
+        head = item.bytes.data();
+    }
+    Protocol::encodeHeader(type, static_cast<std::uint32_t>(prefixSize + length), head);
+    if (prefixSize > 0) {
+        std::memcpy(head + Protocol::HEADER_SIZE, prefix, prefixSize);
+    }
+    item.file = std::move(file);
+    item.fileOffset = offset;
+    item.fileLength = length;
+    enqueue(std::move(item));
+}
+
+void EventServer::Connection::sendFrame(PooledBuffer frame) {
+    OutboundItem item;
+    item.frame = std::move(frame);
+    enqueue(std::move(item));
+}
+
+void EventServer::Connection::enqueue(OutboundItem item) {
+    std::lock_guard<std::mutex> lock(writeMutex);
+    if (closed) {
+        return;
+    }
+    outBytes += item.memorySize() + item.fileLength;
+    outbound.push_back(std::move(item));
+    if (outbound.size() == 1) {
+        // Se o socket encher, o restante é enviado quando o epoll sinalizar EPOLLOUT
+        if (!flushLocked()) {
+            closed = true;
+            return;
+        }
+    }
+    updateReadingLocked();
+}
+
+void EventServer::Connection::updateReadingLocked() {
+    bool pause;
+    if (!readPaused && outBytes > OUTBOUND_HIGH_WATER) {
+        pause = true;
+    } else if (readPaused && outBytes <= OUTBOUND_LOW_WATER) {
+        pause = false;
+    } else {
+        return;
+    }
+    if (closed) {
+        return;
+    }
+    readPaused = pause;
+    if (pause) {
+        EventServer::ioCounters().readPauses.fetch_add(1, std::memory_order_relaxed);
+    }
+    // Com edge-triggered, o EPOLL_CTL_MOD que religa o EPOLLIN gera um evento se
+    // já houver dados no socket, então nada que chegou durante a pausa se perde
+    epoll_event event{};
+    event.events = EPOLLOUT | EPOLLRDHUP | EPOLLET;
+    if (!pause) {
+        event.events |= EPOLLIN;
+    }
+    event.data.fd = fd;
+    epoll_ctl(epollFd, EPOLL_CTL_MOD, fd, &event);
+}
+
+bool EventServer::Connection::flushLocked() {
+    auto& counters = EventServer::ioCounters();
+    while (!outbound.empty()) {
+        auto& front = outbound.front();
+
+        std::size_t memorySize = front.memorySize();
+        if (outOffset < memorySize) {
+            // MSG_MORE junta o cabeçalho com os dados do arquivo no mesmo segmento TCP
+            int flags = MSG_NOSIGNAL | (front.fileLength > 0 ? MSG_MORE : 0);
+            ssize_t written = ::send(fd, front.memoryData() + outOffset, memorySize - outOffset, flags);
+            counters.sendCalls.fetch_add(1, std::memory_order_relaxed);
+            if (written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return errno == EAGAIN || errno == EWOULDBLOCK;
+            }
+            outOffset += static_cast<std::size_t>(written);
+            outBytes -= static_cast<std::size_t>(written);
+            if (outOffset < memorySize) {
+                continue;
+            }
+        }
+
+        while (front.fileLength > 0) {
+            ssize_t sent = ::sendfile(fd, front.file->get(), &front.fileOffset, front.fileLength);
+            counters.sendfileCalls.fetch_add(1, std::memory_order_relaxed);
+            if (sent < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return errno == EAGAIN || errno == EWOULDBLOCK;
+            }
+            if (sent == 0) {
+                return false; // Arquivo menor que o esperado: a mensagem ficaria truncada
+            }
+            front.fileLength -= static_cast<std::size_t>(sent);
+            outBytes -= static_cast<std::size_t>(sent);
+            counters.fileBytes.fetch_add(static_cast<std::uint64_t>(sent), std::memory_order_relaxed);
+        }
+
+        outbound.pop_front();
+        outOffset = 0;
+    }
+    return true;
+}
+
+EventServer::IoCounters& EventServer::ioCounters() {
+    static IoCounters counters;
+    return counters;
+}
+
+EventServer::EventServer(int port, std::size_t threadCount, MessageHandler handler)
+    : port(port), handler(std::move(handler)) {
+    if (threadCount == 0) {
+        threadCount = 1;
+    }
+    for (std::size_t i = 0; i < threadCount; ++i) {
+        auto reactor = std::make_unique<Reactor>();
+        reactor->epollFd = epoll_create1(EPOLL_CLOEXEC);
+        reactor->wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (reactor->epollFd < 0 || reactor->wakeFd < 0) {
+            throw std::runtime_error(std::string("ERRO ao criar epoll: ") + std::strerror(errno));
+        }
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.fd = reactor->wakeFd;
+        epoll_ctl(reactor->epollFd, EPOLL_CTL_ADD, reactor->wakeFd, &event);
+        reactors.push_back(std::move(reactor));
+    }
+}
+
+EventServer::~EventServer() {
+    stop();
+    for (auto& reactor : reactors) {
+        for (auto& entry : reactor->connections) {
+            entry.second->closed = true;
+            close(entry.first);
+        }
+        close(reactor->epollFd);
+        close(reactor->wakeFd);
+    }
+}
+
+void EventServer::run() {
+    listenFd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listenFd < 0) {
+        throw std::runtime_error(std::string("ERRO ao criar socket servidor: ") + std::strerror(errno));
+    }
+
+    sockaddr_in serv_addr{};
+    serv_addr.sin_family = AF_INET;
+    serv_addr.sin_addr.s_addr = INADDR_ANY;
+    serv_addr.sin_port = htons(port);
+
+    // Permite a reutilização do endereço para evitar erros de "Address already in use"
+    int opt = 1;
+    if (setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt))) {
+        throw std::runtime_error(std::string("ERRO ao configurar SO_REUSEADDR: ") + std::strerror(errno));
+    }
+
+    if (bind(listenFd, (struct sockaddr *) &serv_addr, sizeof(serv_addr)) < 0) {
+        throw std::runtime_error(std::string("ERRO ao atrelar o endereço ao socket: ") + std::strerror(errno));
+    }
+
+    if (listen(listenFd, SOMAXCONN) < 0) {
+        throw std::runtime_error(std::string("ERRO ao escutar no socket: ") + std::strerror(errno));
+    }
+
+    // O primeiro reator também aceita conexões e as distribui entre todos
+    epoll_event event{};
+    event.events = EPOLLIN | EPOLLET;
+    event.data.fd = listenFd;
+    epoll_ctl(reactors[0]->epollFd, EPOLL_CTL_ADD, listenFd, &event);
+
+    std::vector<std::thread> threads;
+    for (std::size_t i = 1; i < reactors.size(); ++i) {
+        threads.emplace_back(&EventServer::reactorLoop, this, std::ref(*reactors[i]), false);
+    }
+    reactorLoop(*reactors[0], true);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    close(listenFd);
+    listenFd = -1;
+}
+
+void EventServer::stop() {
+    stopping = true;
+    for (auto& reactor : reactors) {
+        std::uint64_t one = 1;
+        ssize_t ignored = write(reactor->wakeFd, &one, sizeof(one));
+        (void) ignored;
+    }
+}
+
+void EventServer::reactorLoop(Reactor& reactor, bool acceptsConnections) {
+    epoll_event events[MAX_EVENTS];
+    while (!stopping) {
+        int count = epoll_wait(reactor.epollFd, events, MAX_EVENTS, -1);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+
+        for (int i = 0; i < count; ++i) {
+            int fd = events[i].data.fd;
+            if (fd == reactor.wakeFd) {
+                continue;
+            }
+            if (acceptsConnections && fd == listenFd) {
+                acceptConnections();
+                continue;
+            }
+
+            ConnectionPtr connection;
+            {
+                std::lock_guard<std::mutex> lock(reactor.connectionsMutex);
+                auto it = reactor.connections.find(fd);
+                if (it == reactor.connections.end()) {
+                    continue;
+                }
+                connection = it->second;
+            }
+
+            std::uint32_t flags = events[i].events;
+            if (flags & (EPOLLERR | EPOLLHUP)) {
+                closeConnection(reactor, connection);
+                continue;
+            }
+            if (flags & EPOLLOUT) {
+                std::lock_guard<std::mutex> lock(connection->writeMutex);
+                if (!connection->flushLocked()) {
+                    connection->closed = true;
+                } else {
+                    connection->updateReadingLocked();
+                }
+            }
+            if (flags & (EPOLLIN | EPOLLRDHUP)) {
+                handleReadable(reactor, connection);
+            } else if (connection->closed) {
+                closeConnection(reactor, connection);
+            }
+        }
+    }
+}
+
+void EventServer::acceptConnections() {
+    while (true) {
+        sockaddr_in clientAddr{};
+        socklen_t clientLen = sizeof(clientAddr);
+        int clientFd = accept4(listenFd, (struct sockaddr *) &clientAddr, &clientLen,
+                               SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (clientFd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            return; // EAGAIN: todas as conexões pendentes foram aceitas
+        }
+
+        int opt = 1;
+        setsockopt(clientFd, IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt));
+
+        // Captura o endereço do cliente
+        char clientIP[INET_ADDRSTRLEN];
+        inet_ntop(AF_INET, &clientAddr.sin_addr, clientIP, sizeof(clientIP));
+        ConnectionPtr connection(new Connection(clientFd, clientIP, ntohs(clientAddr.sin_port)));
+
+        Reactor& reactor = *reactors[nextReactor];
+        nextReactor = (nextReactor + 1) % reactors.size();
+        connection->epollFd = reactor.epollFd;
+        {
+            std::lock_guard<std::mutex> lock(reactor.connectionsMutex);
+            reactor.connections[clientFd] = connection;
+        }
+        openConnections.fetch_add(1, std::memory_order_relaxed);
+
+        epoll_event event{};
+        event.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+        event.data.fd = clientFd;
+        if (epoll_ctl(reactor.epollFd, EPOLL_CTL_ADD, clientFd, &event) < 0) {
+            closeConnection(reactor, connection);
+        }
+    }
+}
+
+void EventServer::handleReadable(Reactor& reactor, const ConnectionPtr& connection) {
+    // Edge-triggered: lê até o kernel não ter mais dados (EAGAIN) ou até a fila
+    // de saída encher; nesse caso o EPOLLIN religado gera um novo evento depois
+    auto& buffer = connection->inBuffer;
+    std::size_t& start = connection->inStart;
+    std::size_t& end = connection->inEnd;
+    bool peerClosed = false;
+    while (!connection->readPaused) {
+        if (buffer.size() - end < READ_CHUNK) {
+            // Move a mensagem parcial para o início e só cresce se ainda faltar espaço
+            if (start > 0) {
+                std::memmove(buffer.data(), buffer.data() + start, end - start);
+                end -= start;
+                start = 0;
+            }
+            if (buffer.size() - end < READ_CHUNK) {
+                buffer.resize(std::max(buffer.size() * 2, end + READ_CHUNK));
+            }
+        }
+        ssize_t readBytes = ::read(connection->fd, buffer.data() + end, buffer.size() - end);
+        if (readBytes > 0) {
+            end += static_cast<std::size_t>(readBytes);
+            if (!dispatchMessages(connection)) {
+                peerClosed = true;
+                break;
+            }
+            continue;
+        }
+        if (readBytes == 0) {
+            peerClosed = true;
+        } else if (errno == EINTR) {
+            continue;
+        } else if (errno != EAGAIN && errno != EWOULDBLOCK) {
+            peerClosed = true;
+        }
+        break;
+    }
+
+    if (peerClosed || connection->closed) {
+        closeConnection(reactor, connection);
+    }
+}
+
+bool EventServer::dispatchMessages(const ConnectionPtr& connection) {
+    auto& buffer = connection->inBuffer;
+    std::size_t& start = connection->inStart;
+    std::size_t& end = connection->inEnd;
+    auto& payload = connection->payload;
+
+    while (end - start >= Protocol::HEADER_SIZE) {
+        Protocol::MessageType type;
+        std::uint32_t payloadSize = Protocol::decodeHeader(buffer.data() + start, type);
+        if (payloadSize > Protocol::maxFrameSize()) {
+            return false; // Tamanho inválido: encerra a conexão em vez de alocar
+        }
+        if (end - start - Protocol::HEADER_SIZE < payloadSize) {
+            break; // Mensagem parcial: aguarda mais dados
+        }
+
+        const std::uint8_t* payloadStart = buffer.data() + start + Protocol::HEADER_SIZE;
+        payload.assign(payloadStart, payloadStart + payloadSize);
+        start += Protocol::HEADER_SIZE + payloadSize;
+        handler(connection, type, payload);
+        if (connection->closed) {
+            return false;
+        }
+    }
+
+    // Sem bytes pendentes, a próxima leitura recomeça do início do buffer
+    if (start == end) {
+        start = 0;
+        end = 0;
+    }
+    return true;
+}
+
+void EventServer::closeConnection(Reactor& reactor, const ConnectionPtr& connection) {
+    {
+        std::lock_guard<std::mutex> lock(reactor.connectionsMutex);
+        auto it = reactor.connections.find(connection->fd);
+        if (it == reactor.connections.end() || it->second != connection) {
+            return;
+        }
+        reactor.connections.erase(it);
+    }
+    openConnections.fetch_sub(1, std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(connection->writeMutex);
+    connection->closed = true;
+    connection->outbound.clear();
+    connection->outBytes = 0;
+    close(connection->fd);
+}
@@ -0,0 +1,168 @@
+#ifndef EVENT_SERVER_H
+#define EVENT_SERVER_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <sys/types.h>
+
+#include "BufferPool.h"
+#include "FileDescriptor.h"
+#include "Protocol.h"
+
+// Servidor orientado a eventos: um número fixo de threads reator, cada uma com
+// seu próprio epoll (edge-triggered) e sockets não bloqueantes. Cada conexão
+// guarda o estado de leitura (mensagem parcial) e a fila de saída (escrita parcial).
+// Os envios em memória usam MSG_NOSIGNAL, mas sendfile não aceita flags: o
+// processo que hospeda o servidor deve ignorar SIGPIPE (ver main.cpp).
+class EventServer {
+public:
+    class Connection {
+    public:
+        // Enfileira uma mensagem e tenta enviá-la imediatamente.
+        // Pode ser chamado de qualquer thread.
+        void send(Protocol::MessageType type, const std::vector<std::uint8_t>& payload);
+        void send(Protocol::MessageType type, const std::uint8_t* data, std::size_t size);
+        void send(Protocol::MessageType type, const Protocol::PayloadPart* parts, std::size_t partCount);
+        // Envia cabeçalho + prefix da memória e em seguida `length` bytes do arquivo
+        // a partir de `offset` com sendfile, sem copiar o conteúdo para o espaço de usuário.
+        void sendFile(Protocol::MessageType type, const std::uint8_t* prefix, std::size_t prefixSize,
+                      std::shared_ptr<FileDescriptor> file, off_t offset, std::size_t length);
+        // Enfileira uma mensagem já codificada (cabeçalho + payload) sem copiá-la;
+        // o buffer é compartilhado até terminar de ser enviado
+        void sendFrame(PooledBuffer frame);
+
+        const std::string& remoteIp() const { return ip; }
+        int remotePort() const { return port; }
+        bool isClosed() const { return closed; }
+        // Índice do vizinho que abriu a conexão (informado no HANDSHAKE), -1 se desconhecido
+        int neighbor() const { return neighborIndex.load(std::memory_order_relaxed); }
+        void setNeighbor(int index) { neighborIndex.store(index, std::memory_order_relaxed); }
+
+    private:
+        friend class EventServer;
+
+        Connection(int fd, std::string ip, int port)
+            : fd(fd), ip(std::move(ip)), port(port) {}
+
+        int fd;
+        std::string ip;
+        int port;
+        std::atomic<bool> closed { false };
+        std::atomic<int> neighborIndex { -1 };
+
+        // Reator que vigia o socket, para ligar e desligar o EPOLLIN
+        int epollFd = -1;
+
+        // Estado de leitura: bytes recebidos ainda não consumidos ficam em
+        // inBuffer[inStart, inEnd). O tamanho do vetor é a capacidade, que só
+        // cresce; a leitura usa o espaço livre depois de inEnd sem zerá-lo.
+        std::vector<std::uint8_t> inBuffer;
+        std::size_t inStart = 0;
+        std::size_t inEnd = 0;
+        // Payload entregue ao handler, reaproveitado entre as mensagens
+        std::vector<std::uint8_t> payload;
+
+        // Estado de escrita: mensagens codificadas aguardando o socket aceitar mais dados.
+        // Os bytes em memória ficam em um frame do pool (sem cópia), em shortBytes
+        // (cabeçalhos de sendfile, sem alocação) ou em bytes. Um item pode terminar
+        // com um trecho de arquivo enviado por sendfile.
+        struct OutboundItem {
+            PooledBuffer frame;
+            std::array<std::uint8_t, 16> shortBytes;
+            std::size_t shortSize = 0;
+            std::vector<std::uint8_t> bytes;
+            std::shared_ptr<FileDescriptor> file;
+            off_t fileOffset = 0;
+            std::size_t fileLength = 0;
+
+            const std::uint8_t* memoryData() const {
+                return frame ? frame.data() : shortSize > 0 ? shortBytes.data() : bytes.data();
+            }
+            std::size_t memorySize() const {
+                return frame ? frame.size() : shortSize > 0 ? shortSize : bytes.size();
+            }
+        };
+        std::mutex writeMutex;
+        std::deque<OutboundItem> outbound;
+        std::size_t outOffset = 0;
+        // Bytes na fila de saída (memória + trechos de arquivo) ainda não enviados
+        std::size_t outBytes = 0;
+        // Leitura suspensa (sem EPOLLIN) enquanto a fila de saída está cheia.
+        // Alterado com writeMutex travado; lido pelo reator sem o lock.
+        std::atomic<bool> readPaused { false };
+
+        void enqueue(OutboundItem item);
+
+        // Chamado com writeMutex travado. Retorna false se o socket falhou.
+        bool flushLocked();
+        // Chamado com writeMutex travado. Suspende a leitura quando a fila de saída
+        // passa do limite e a retoma quando ela esvazia o suficiente: um cliente que
+        // pede sem ler as respostas não faz a fila crescer sem limite.
+        void updateReadingLocked();
+    };
+
+    // Contadores globais do caminho de envio, para medir cópias e syscalls por bloco
+    struct IoCounters {
+        std::atomic<std::uint64_t> sendCalls { 0 };
+        std::atomic<std::uint64_t> sendfileCalls { 0 };
+        // Bytes de payload copiados em espaço de usuário para a fila de saída
+        std::atomic<std::uint64_t> copiedBytes { 0 };
+        // Bytes enviados direto do page cache via sendfile
+        std::atomic<std::uint64_t> fileBytes { 0 };
+        // Vezes em que uma conexão teve a leitura suspensa pela fila de saída cheia
+        std::atomic<std::uint64_t> readPauses { 0 };
+    };
+    static IoCounters& ioCounters();
+
+    using ConnectionPtr = std::shared_ptr<Connection>;
+    using MessageHandler = std::function<void(const ConnectionPtr&, Protocol::MessageType,
+                                              const std::vector<std::uint8_t>&)>;
+
+    EventServer(int port, std::size_t threadCount, MessageHandler handler);
+    ~EventServer();
+
+    EventServer(const EventServer&) = delete;
+    EventServer& operator=(const EventServer&) = delete;
+
+    // Abre o socket de escuta e atende conexões até stop(). Lança exceção se não conseguir escutar.
+    void run();
+    void stop();
+
+    // Conexões de clientes abertas neste momento
+    std::size_t connectionCount() const { return openConnections.load(std::memory_order_relaxed); }
+
+private:
+    struct Reactor {
+        int epollFd = -1;
+        int wakeFd = -1;
+        std::mutex connectionsMutex;
+        std::unordered_map<int, ConnectionPtr> connections;
+    };
+
+    int port;
+    MessageHandler handler;
+    std::atomic<bool> stopping { false };
+    int listenFd = -1;
+    std::vector<std::unique_ptr<Reactor>> reactors;
+    std::size_t nextReactor = 0;
+    std::atomic<std::size_t> openConnections { 0 };
+
+    void reactorLoop(Reactor& reactor, bool acceptsConnections);
+    void acceptConnections();
+    void handleReadable(Reactor& reactor, const ConnectionPtr& connection);
+    void closeConnection(Reactor& reactor, const ConnectionPtr& connection);
+    bool dispatchMessages(const ConnectionPtr& connection);
+};
+
+#endif
@@ -0,0 +1,27 @@
+#ifndef FILE_DESCRIPTOR_H
+#define FILE_DESCRIPTOR_H
+
+#include <unistd.h>
+
+// Dono de um descritor de arquivo: fecha ao ser destruído.
+// Compartilhado via std::shared_ptr quando vários envios pendentes usam o mesmo arquivo.
+class FileDescriptor {
+public:
+    explicit FileDescriptor(int fd = -1) : fd(fd) {}
+    ~FileDescriptor() {
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+
+    FileDescriptor(const FileDescriptor&) = delete;
+    FileDescriptor& operator=(const FileDescriptor&) = delete;
+
+    int get() const { return fd; }
+    bool valid() const { return fd >= 0; }
+
+private:
+    int fd;
+};
+
+#endif
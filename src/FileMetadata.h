@@ -1,7 +1,12 @@
 #ifndef FILE_METADATA_H
 #define FILE_METADATA_H
 
+#include <array>
 #include <string>
+#include <vector>
+
+// SHA-256 de um bloco (folha da árvore de Merkle)
+using BlockHash = std::array<unsigned char, 32>;
 
 struct FileInfo {
     std::string fileName;
@@ -9,6 +14,10 @@ struct FileInfo {
     int blockSize;
     int blockCount;
     std::string checksum;
+    // Hash de cada bloco e raiz da árvore de Merkle formada por eles.
+    // Vazios em metadata antiga, que só permite verificar o arquivo inteiro.
+    std::vector<BlockHash> blockHashes;
+    std::string merkleRoot;
 };
 
 #endif
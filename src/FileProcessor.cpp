@@ -1,173 +1,69 @@
 #include "FileProcessor.h"
 
+#include "BinaryMetadata.h"
+#include "FileDescriptor.h"
+#include "Sha256.h"
+
 #include <algorithm>
 #include <array>
+#include <cerrno>
+#include <condition_variable>
 #include <cstdint>
 #include <cstring>
+#include <exception>
+#include <fcntl.h>
 #include <filesystem>
 #include <fstream>
-#include <iomanip>
+#include <limits>
+#include <map>
+#include <mutex>
 #include <sstream>
 #include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
 #include <unordered_map>
 #include <vector>
 
 namespace {
 
-class Sha256 {
-public:
-    Sha256() {
-        reset();
-    }
-
-    void update(const unsigned char* data, std::size_t len) {
-        while (len > 0) {
-            std::size_t copyLen = std::min(len, blockSize - bufferLen);
-            std::memcpy(buffer.data() + bufferLen, data, copyLen);
-            bufferLen += copyLen;
-            data += copyLen;
-            len -= copyLen;
-            totalBits += static_cast<std::uint64_t>(copyLen) * 8;
-
-            if (bufferLen == blockSize) {
-                transform(buffer.data());
-                bufferLen = 0;
-            }
-        }
-    }
-
-    std::array<unsigned char, 32> finalize() {
-        buffer[bufferLen++] = 0x80;
-        if (bufferLen > 56) {
-            while (bufferLen < blockSize) {
-                buffer[bufferLen++] = 0;
-            }
-            transform(buffer.data());
-            bufferLen = 0;
-        }
-
-        while (bufferLen < 56) {
-            buffer[bufferLen++] = 0;
-        }
-
-        for (int i = 7; i >= 0; --i) {
-            buffer[bufferLen++] = static_cast<unsigned char>((totalBits >> (i * 8)) & 0xFF);
-        }
-
-        transform(buffer.data());
-
-        std::array<unsigned char, 32> hash{};
-        for (int i = 0; i < 8; ++i) {
-            hash[i * 4 + 0] = static_cast<unsigned char>((state[i] >> 24) & 0xFF);
-            hash[i * 4 + 1] = static_cast<unsigned char>((state[i] >> 16) & 0xFF);
-            hash[i * 4 + 2] = static_cast<unsigned char>((state[i] >> 8) & 0xFF);
-            hash[i * 4 + 3] = static_cast<unsigned char>(state[i] & 0xFF);
-        }
-
-        reset();
-        return hash;
+std::string bytesToHex(const unsigned char* data, std::size_t length) {
+    static const char digits[] = "0123456789abcdef";
+    std::string hex(length * 2, '0');
+    for (std::size_t i = 0; i < length; ++i) {
+        hex[i * 2] = digits[data[i] >> 4];
+        hex[i * 2 + 1] = digits[data[i] & 0x0F];
     }
+    return hex;
+}
 
-private:
-    static constexpr std::size_t blockSize = 64;
-    std::array<unsigned char, blockSize> buffer{};
-    std::size_t bufferLen = 0;
-    std::uint64_t totalBits = 0;
-    std::array<std::uint32_t, 8> state{};
-
-    static constexpr std::uint32_t k[64] = {
-        0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
-        0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
-        0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
-        0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
-        0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
-        0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
-        0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
-        0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
-    };
-
-    static std::uint32_t rotr(std::uint32_t value, std::uint32_t count) {
-        return (value >> count) | (value << (32 - count));
-    }
+int hexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    throw std::runtime_error(std::string("Caractere hexadecimal inválido em metadata: ") + c);
+}
 
-    static std::uint32_t choose(std::uint32_t x, std::uint32_t y, std::uint32_t z) {
-        return (x & y) ^ (~x & z);
+void hexToBytes(const std::string& hex, unsigned char* out, std::size_t length) {
+    if (hex.size() != length * 2) {
+        throw std::runtime_error("Tamanho de hash inválido em metadata");
     }
-
-    static std::uint32_t majority(std::uint32_t x, std::uint32_t y, std::uint32_t z) {
-        return (x & y) ^ (x & z) ^ (y & z);
+    for (std::size_t i = 0; i < length; ++i) {
+        out[i] = static_cast<unsigned char>((hexValue(hex[i * 2]) << 4) | hexValue(hex[i * 2 + 1]));
     }
+}
 
-    void transform(const unsigned char* chunk) {
-        std::uint32_t w[64];
-        for (int i = 0; i < 16; ++i) {
-            w[i] = (static_cast<std::uint32_t>(chunk[i * 4]) << 24) |
-                   (static_cast<std::uint32_t>(chunk[i * 4 + 1]) << 16) |
-                   (static_cast<std::uint32_t>(chunk[i * 4 + 2]) << 8) |
-                   static_cast<std::uint32_t>(chunk[i * 4 + 3]);
-        }
-
-        for (int i = 16; i < 64; ++i) {
-            std::uint32_t s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
-            std::uint32_t s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
-            w[i] = w[i - 16] + s0 + w[i - 7] + s1;
-        }
-
-        std::uint32_t a = state[0];
-        std::uint32_t b = state[1];
-        std::uint32_t c = state[2];
-        std::uint32_t d = state[3];
-        std::uint32_t e = state[4];
-        std::uint32_t f = state[5];
-        std::uint32_t g = state[6];
-        std::uint32_t h = state[7];
-
-        for (int i = 0; i < 64; ++i) {
-            std::uint32_t S1 = rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25);
-            std::uint32_t ch = choose(e, f, g);
-            std::uint32_t temp1 = h + S1 + ch + k[i] + w[i];
-            std::uint32_t S0 = rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22);
-            std::uint32_t maj = majority(a, b, c);
-            std::uint32_t temp2 = S0 + maj;
-
-            h = g;
-            g = f;
-            f = e;
-            e = d + temp1;
-            d = c;
-            c = b;
-            b = a;
-            a = temp1 + temp2;
-        }
-
-        state[0] += a;
-        state[1] += b;
-        state[2] += c;
-        state[3] += d;
-        state[4] += e;
-        state[5] += f;
-        state[6] += g;
-        state[7] += h;
-    }
-
-    void reset() {
-        state = {
-            0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
-            0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
-        };
-        buffer.fill(0);
-        bufferLen = 0;
-        totalBits = 0;
+std::vector<BlockHash> parseBlockHashes(const std::string& hex, int blockCount) {
+    const std::size_t hashHexSize = sizeof(BlockHash) * 2;
+    if (blockCount < 0 || hex.size() != static_cast<std::size_t>(blockCount) * hashHexSize) {
+        throw std::runtime_error("Quantidade de hashes de bloco não confere com block_count");
     }
-};
-
-std::string bytesToHex(const unsigned char* data, std::size_t length) {
-    std::ostringstream oss;
-    oss << std::hex << std::setfill('0');
-    for (std::size_t i = 0; i < length; ++i) {
-        oss << std::setw(2) << static_cast<int>(data[i]);
+    std::vector<BlockHash> hashes(static_cast<std::size_t>(blockCount));
+    for (std::size_t i = 0; i < hashes.size(); ++i) {
+        hexToBytes(hex.substr(i * hashHexSize, hashHexSize), hashes[i].data(), hashes[i].size());
     }
-    return oss.str();
+    return hashes;
 }
 
 FileProcessor::MetadataContent parseKeyValueStream(std::istream& input) {
@@ -199,6 +95,22 @@ FileProcessor::MetadataContent parseKeyValueStream(std::istream& input) {
     content.info.blockCount = std::stoi(getValue("block_count"));
     content.info.checksum = getValue("checksum");
     content.blocksDirectory = getValue("blocks_dir");
+    auto sourceIt = kv.find("source_file");
+    if (sourceIt != kv.end()) {
+        content.sourceFile = sourceIt->second;
+    }
+
+    // Hashes por bloco são opcionais (metadata antiga não os possui)
+    auto hashesIt = kv.find("block_hashes");
+    auto rootIt = kv.find("merkle_root");
+    if (hashesIt != kv.end() && rootIt != kv.end()) {
+        content.info.blockHashes = parseBlockHashes(hashesIt->second, content.info.blockCount);
+        content.info.merkleRoot = rootIt->second;
+        auto root = FileProcessor::computeMerkleRoot(content.info.blockHashes);
+        if (bytesToHex(root.data(), root.size()) != content.info.merkleRoot) {
+            throw std::runtime_error("Hashes de bloco não conferem com merkle_root");
+        }
+    }
     return content;
 }
 
@@ -210,17 +122,346 @@ std::string serializeKeyValue(const FileProcessor::MetadataContent& content) {
         << "block_count=" << content.info.blockCount << '\n'
         << "checksum=" << content.info.checksum << '\n'
         << "blocks_dir=" << content.blocksDirectory << '\n';
+    if (!content.sourceFile.empty()) {
+        oss << "source_file=" << content.sourceFile << '\n';
+    }
+    if (!content.info.blockHashes.empty()) {
+        oss << "merkle_root=" << content.info.merkleRoot << '\n'
+            << "block_hashes=";
+        for (const auto& blockHash : content.info.blockHashes) {
+            oss << bytesToHex(blockHash.data(), blockHash.size());
+        }
+        oss << '\n';
+    }
     return oss.str();
 }
 
+void appendBinaryString(std::string& out, const std::string& value) {
+    std::uint32_t length = static_cast<std::uint32_t>(value.size());
+    out.append(reinterpret_cast<const char*>(&length), sizeof(length));
+    out.append(value);
+}
+
+std::string readBinaryString(const unsigned char*& cursor, const unsigned char* end) {
+    std::uint32_t length;
+    if (static_cast<std::size_t>(end - cursor) < sizeof(length)) {
+        throw std::runtime_error("Seção de strings da metadata binária truncada");
+    }
+    std::memcpy(&length, cursor, sizeof(length));
+    cursor += sizeof(length);
+    if (static_cast<std::size_t>(end - cursor) < length) {
+        throw std::runtime_error("Seção de strings da metadata binária truncada");
+    }
+    std::string value(reinterpret_cast<const char*>(cursor), length);
+    cursor += length;
+    return value;
+}
+
+bool isBinaryMetadata(const void* data, std::size_t size) {
+    return size >= sizeof(BinaryMetadata::magic) &&
+           std::memcmp(data, BinaryMetadata::magic, sizeof(BinaryMetadata::magic)) == 0;
+}
+
+std::string serializeBinary(const FileProcessor::MetadataContent& content) {
+    const FileInfo& info = content.info;
+    if (info.fileSize < 0 || info.blockSize <= 0 || info.blockCount < 0) {
+        throw std::runtime_error("Metadata com tamanhos inválidos não pode ser serializada");
+    }
+
+    BinaryMetadata::Header header{};
+    std::memcpy(header.magic, BinaryMetadata::magic, sizeof(header.magic));
+    header.version = BinaryMetadata::version;
+    header.headerSize = sizeof(header);
+    header.fileSize = static_cast<std::uint64_t>(info.fileSize);
+    header.blockSize = static_cast<std::uint32_t>(info.blockSize);
+    header.blockCount = static_cast<std::uint32_t>(info.blockCount);
+    hexToBytes(info.checksum, header.checksum, sizeof(header.checksum));
+    if (!info.blockHashes.empty()) {
+        header.flags |= BinaryMetadata::hasBlockHashes;
+        hexToBytes(info.merkleRoot, header.merkleRoot, sizeof(header.merkleRoot));
+    }
+
+    std::string strings;
+    appendBinaryString(strings, info.fileName);
+    appendBinaryString(strings, content.blocksDirectory);
+    appendBinaryString(strings, content.sourceFile);
+
+    const std::size_t alignment = BinaryMetadata::hashTableAlignment;
+    header.stringsOffset = sizeof(header);
+    header.stringsSize = strings.size();
+    header.hashesOffset = (header.stringsOffset + header.stringsSize + alignment - 1) / alignment * alignment;
+
+    std::size_t hashBytes = info.blockHashes.size() * sizeof(BlockHash);
+    std::string out;
+    out.reserve(header.hashesOffset + hashBytes);
+    out.append(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.append(strings);
+    out.resize(header.hashesOffset, '\0');
+    if (hashBytes > 0) {
+        out.append(reinterpret_cast<const char*>(info.blockHashes.data()), hashBytes);
+    }
+    return out;
+}
+
+// Lê a metadata binária direto da memória (buffer recebido ou arquivo mapeado).
+// verifyRoot confere a tabela de hashes contra a raiz de Merkle do cabeçalho.
+FileProcessor::MetadataContent parseBinary(const unsigned char* data, std::size_t size, bool verifyRoot) {
+    BinaryMetadata::Header header;
+    if (size < sizeof(header)) {
+        throw std::runtime_error("Metadata binária truncada");
+    }
+    std::memcpy(&header, data, sizeof(header));
+    if (header.version != BinaryMetadata::version) {
+        throw std::runtime_error("Versão de metadata binária não suportada: " + std::to_string(header.version));
+    }
+    if (header.headerSize < sizeof(header) ||
+        header.stringsOffset < header.headerSize || header.stringsOffset > size ||
+        header.stringsSize > size - header.stringsOffset) {
+        throw std::runtime_error("Cabeçalho de metadata binária inválido");
+    }
+    // Os tamanhos viram long long/int em FileInfo: valores fora da faixa são recusados
+    // antes das conversões, e o arredondamento abaixo não transborda
+    constexpr auto maxInt = static_cast<std::uint32_t>(std::numeric_limits<int>::max());
+    if (header.blockSize == 0 || header.blockSize > maxInt || header.blockCount > maxInt ||
+        header.fileSize > static_cast<std::uint64_t>(std::numeric_limits<long long>::max())) {
+        throw std::runtime_error("Tamanhos fora da faixa na metadata binária");
+    }
+    std::uint64_t expectedBlocks = (header.fileSize + header.blockSize - 1) / header.blockSize;
+    if (header.blockCount != expectedBlocks) {
+        throw std::runtime_error("block_count não confere com o tamanho do arquivo na metadata binária");
+    }
+
+    FileProcessor::MetadataContent content;
+    const unsigned char* cursor = data + header.stringsOffset;
+    const unsigned char* stringsEnd = cursor + header.stringsSize;
+    content.info.fileName = readBinaryString(cursor, stringsEnd);
+    content.blocksDirectory = readBinaryString(cursor, stringsEnd);
+    content.sourceFile = readBinaryString(cursor, stringsEnd);
+
+    content.info.fileSize = static_cast<long long>(header.fileSize);
+    content.info.blockSize = static_cast<int>(header.blockSize);
+    content.info.blockCount = static_cast<int>(header.blockCount);
+    content.info.checksum = bytesToHex(header.checksum, sizeof(header.checksum));
+
+    if (header.flags & BinaryMetadata::hasBlockHashes) {
+        std::size_t hashBytes = static_cast<std::size_t>(header.blockCount) * sizeof(BlockHash);
+        if (header.hashesOffset > size || hashBytes > size - header.hashesOffset) {
+            throw std::runtime_error("Tabela de hashes da metadata binária truncada");
+        }
+        // A tabela já está no formato em memória: uma cópia, sem decodificar hex
+        content.info.blockHashes.resize(header.blockCount);
+        std::memcpy(content.info.blockHashes.data(), data + header.hashesOffset, hashBytes);
+        content.info.merkleRoot = bytesToHex(header.merkleRoot, sizeof(header.merkleRoot));
+
+        if (verifyRoot) {
+            auto root = FileProcessor::computeMerkleRoot(content.info.blockHashes);
+            if (std::memcmp(root.data(), header.merkleRoot, root.size()) != 0) {
+                throw std::runtime_error("Hashes de bloco não conferem com merkle_root");
+            }
+        }
+    }
+    return content;
+}
+
+// Mapeamento somente leitura de um arquivo inteiro
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path) {
+        FileDescriptor fd(open(path.c_str(), O_RDONLY | O_CLOEXEC));
+        struct stat fileStat{};
+        if (!fd.valid() || fstat(fd.get(), &fileStat) < 0) {
+            throw std::runtime_error("Não foi possível abrir o arquivo de metadata: " + path);
+        }
+        length = static_cast<std::size_t>(fileStat.st_size);
+        if (length == 0) {
+            return;
+        }
+        void* mapped = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd.get(), 0);
+        if (mapped == MAP_FAILED) {
+            throw std::runtime_error("Falha ao mapear o arquivo de metadata: " + path);
+        }
+        address = static_cast<const unsigned char*>(mapped);
+    }
+
+    ~MappedFile() {
+        if (address) {
+            munmap(const_cast<unsigned char*>(address), length);
+        }
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const unsigned char* data() const { return address; }
+    std::size_t size() const { return length; }
+
+private:
+    const unsigned char* address = nullptr;
+    std::size_t length = 0;
+};
+
+// Lê exatamente `size` bytes a partir de `offset`
+void readRange(int fd, char* out, std::size_t size, off_t offset) {
+    std::size_t done = 0;
+    while (done < size) {
+        ssize_t result = pread(fd, out + done, size - done, offset + static_cast<off_t>(done));
+        if (result < 0 && errno == EINTR) {
+            continue;
+        }
+        if (result < 0) {
+            throw std::runtime_error(std::string("Falha ao ler o arquivo de origem: ") + std::strerror(errno));
+        }
+        if (result == 0) {
+            throw std::runtime_error("O arquivo de origem diminuiu durante a leitura");
+        }
+        done += static_cast<std::size_t>(result);
+    }
+}
+
+// Calcula os hashes por bloco e o checksum do arquivo inteiro em paralelo.
+// O arquivo é dividido em lotes de blocos consecutivos: as threads de trabalho
+// leem cada lote, calculam os hashes dos seus blocos (multi-buffer) e gravam os
+// block_N.bin se pedidos. O SHA-256 do arquivo inteiro é sequencial por natureza,
+// então a thread chamadora consome os lotes na ordem do arquivo. O número de
+// lotes à frente do checksum é limitado para não manter o arquivo em memória.
+Sha256::Digest hashFileBlocks(int fd, long long fileSize, std::size_t blockSize, unsigned threads,
+                              const std::filesystem::path& blocksDir, std::vector<BlockHash>& blockHashes) {
+    const std::size_t blockCount = static_cast<std::size_t>(
+        (fileSize + static_cast<long long>(blockSize) - 1) / static_cast<long long>(blockSize));
+    blockHashes.assign(blockCount, BlockHash{});
+
+    // Lotes de ~1 MiB, múltiplos da largura do multi-buffer quando os blocos são pequenos
+    constexpr std::size_t targetBatchBytes = 1 << 20;
+    std::size_t blocksPerBatch = std::max<std::size_t>(1, targetBatchBytes / blockSize);
+    if (blocksPerBatch >= Sha256::lanes) {
+        blocksPerBatch -= blocksPerBatch % Sha256::lanes;
+    }
+    const std::size_t batchCount = (blockCount + blocksPerBatch - 1) / blocksPerBatch;
+    const std::size_t workerCount = std::min<std::size_t>(threads, std::max<std::size_t>(batchCount, 1));
+    const std::size_t maxPending = 2 * workerCount;
+
+    auto batchBytes = [&](std::size_t batch) {
+        long long offset = static_cast<long long>(batch * blocksPerBatch * blockSize);
+        return static_cast<std::size_t>(
+            std::min<long long>(static_cast<long long>(blocksPerBatch * blockSize), fileSize - offset));
+    };
+
+    std::mutex mutex;
+    std::condition_variable readyCondition;
+    std::condition_variable spaceCondition;
+    std::size_t nextBatch = 0;
+    std::size_t nextToDigest = 0;
+    std::map<std::size_t, std::vector<char>> readyBatches;
+    std::vector<std::vector<char>> freeBuffers;
+    std::exception_ptr failure;
+    bool aborted = false;
+
+    auto worker = [&]() {
+        while (true) {
+            std::size_t batch;
+            std::vector<char> buffer;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                spaceCondition.wait(lock, [&] {
+                    return aborted || nextBatch >= batchCount || nextBatch < nextToDigest + maxPending;
+                });
+                if (aborted || nextBatch >= batchCount) {
+                    return;
+                }
+                batch = nextBatch++;
+                if (!freeBuffers.empty()) {
+                    buffer = std::move(freeBuffers.back());
+                    freeBuffers.pop_back();
+                }
+            }
+
+            try {
+                std::size_t size = batchBytes(batch);
+                buffer.resize(blocksPerBatch * blockSize);
+                readRange(fd, buffer.data(), size, static_cast<off_t>(batch * blocksPerBatch * blockSize));
+
+                std::size_t firstBlock = batch * blocksPerBatch;
+                std::size_t blocksInBatch = (size + blockSize - 1) / blockSize;
+                std::vector<const void*> blockData(blocksInBatch);
+                std::vector<std::size_t> blockSizes(blocksInBatch);
+                for (std::size_t i = 0; i < blocksInBatch; ++i) {
+                    blockData[i] = buffer.data() + i * blockSize;
+                    blockSizes[i] = std::min(blockSize, size - i * blockSize);
+                }
+                Sha256::hashMany(blockData.data(), blockSizes.data(),
+                                 blockHashes.data() + firstBlock, blocksInBatch);
+
+                if (!blocksDir.empty()) {
+                    for (std::size_t i = 0; i < blocksInBatch; ++i) {
+                        auto blockPath = blocksDir / ("block_" + std::to_string(firstBlock + i) + ".bin");
+                        std::ofstream blockFile(blockPath, std::ios::binary);
+                        if (!blockFile) {
+                            throw std::runtime_error("Não foi possível criar o arquivo de bloco: " + blockPath.string());
+                        }
+                        blockFile.write(static_cast<const char*>(blockData[i]),
+                                        static_cast<std::streamsize>(blockSizes[i]));
+                    }
+                }
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!failure) {
+                    failure = std::current_exception();
+                }
+                aborted = true;
+                readyCondition.notify_all();
+                spaceCondition.notify_all();
+                return;
+            }
+
+            std::lock_guard<std::mutex> lock(mutex);
+            readyBatches.emplace(batch, std::move(buffer));
+            readyCondition.notify_all();
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (std::size_t i = 0; i < workerCount; ++i) {
+        workers.emplace_back(worker);
+    }
+
+    Sha256 sha;
+    for (std::size_t batch = 0; batch < batchCount; ++batch) {
+        std::vector<char> buffer;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            readyCondition.wait(lock, [&] { return aborted || readyBatches.count(batch) > 0; });
+            if (aborted) {
+                break;
+            }
+            auto it = readyBatches.find(batch);
+            buffer = std::move(it->second);
+            readyBatches.erase(it);
+        }
+
+        sha.update(reinterpret_cast<const unsigned char*>(buffer.data()), batchBytes(batch));
+
+        std::lock_guard<std::mutex> lock(mutex);
+        nextToDigest = batch + 1;
+        freeBuffers.push_back(std::move(buffer));
+        spaceCondition.notify_all();
+    }
+
+    for (auto& thread : workers) {
+        thread.join();
+    }
+    if (failure) {
+        std::rethrow_exception(failure);
+    }
+    return sha.finalize();
+}
+
 }
 
 namespace FileProcessor {
 
 MetadataCreationResult createFileMetadata(const std::string& sourceFile,
                                           std::size_t blockSize,
-                                          const std::string& blocksRoot,
-                                          const std::string& metadataRoot) {
+                                          const MetadataOptions& options) {
     namespace fs = std::filesystem;
 
     if (blockSize == 0) {
@@ -236,47 +477,39 @@ MetadataCreationResult createFileMetadata(const std::string& sourceFile,
         throw std::runtime_error("Nome de arquivo inválido para: " + sourcePath.string());
     }
 
-    fs::path blocksRootPath(blocksRoot);
-    fs::create_directories(blocksRootPath);
-
-    fs::path fileBlocksDir = blocksRootPath / sourcePath.filename();
-    fs::create_directories(fileBlocksDir);
+    fs::path fileBlocksDir;
+    if (options.writeBlockFiles) {
+        fileBlocksDir = fs::path(options.blocksRoot) / sourcePath.filename();
+        fs::create_directories(fileBlocksDir);
+    }
 
-    fs::path metadataRootPath(metadataRoot);
+    fs::path metadataRootPath(options.metadataRoot);
     fs::create_directories(metadataRootPath);
 
-    std::ifstream input(sourcePath, std::ios::binary);
-    if (!input) {
+    FileDescriptor input(open(sourcePath.c_str(), O_RDONLY | O_CLOEXEC));
+    struct stat sourceStat{};
+    if (!input.valid() || fstat(input.get(), &sourceStat) < 0) {
         throw std::runtime_error("Não foi possível abrir o arquivo: " + sourcePath.string());
     }
 
-    Sha256 sha;
-
-    std::vector<char> buffer(blockSize);
-    long long totalBytes = 0;
-    int blockCount = 0;
-
-    while (input) {
-        input.read(buffer.data(), static_cast<std::streamsize>(blockSize));
-        std::streamsize bytesRead = input.gcount();
-        if (bytesRead <= 0) {
-            break;
-        }
-
-        sha.update(reinterpret_cast<const unsigned char*>(buffer.data()), static_cast<std::size_t>(bytesRead));
-
-        fs::path blockPath = fileBlocksDir / ("block_" + std::to_string(blockCount) + ".bin");
-        std::ofstream blockFile(blockPath, std::ios::binary);
-        if (!blockFile) {
-            throw std::runtime_error("Não foi possível criar o arquivo de bloco: " + blockPath.string());
-        }
-        blockFile.write(buffer.data(), bytesRead);
+    long long totalBytes = static_cast<long long>(sourceStat.st_size);
+    long long blockCountLong = (totalBytes + static_cast<long long>(blockSize) - 1) /
+                               static_cast<long long>(blockSize);
+    if (blockCountLong > std::numeric_limits<int>::max()) {
+        throw std::runtime_error("Arquivo com blocos demais para o tamanho de bloco escolhido");
+    }
+    int blockCount = static_cast<int>(blockCountLong);
 
-        totalBytes += bytesRead;
-        ++blockCount;
+    unsigned threads = options.threads;
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
     }
 
-    auto hash = sha.finalize();
+    std::vector<BlockHash> blockHashes;
+    Sha256::Digest hash = hashFileBlocks(input.get(), totalBytes, blockSize, threads,
+                                         fileBlocksDir, blockHashes);
+
+    auto root = computeMerkleRoot(blockHashes);
 
     MetadataContent content{
         FileInfo{
@@ -284,37 +517,93 @@ MetadataCreationResult createFileMetadata(const std::string& sourceFile,
             totalBytes,
             static_cast<int>(blockSize),
             blockCount,
-            bytesToHex(hash.data(), hash.size())
+            bytesToHex(hash.data(), hash.size()),
+            std::move(blockHashes),
+            bytesToHex(root.data(), root.size())
         },
-        fileBlocksDir.string()
+        fileBlocksDir.string(),
+        fs::absolute(sourcePath).lexically_normal().string()
     };
 
     fs::path metadataPath = metadataRootPath / (sourcePath.filename().string() + ".meta");
-    std::ofstream metaFile(metadataPath, std::ios::trunc);
-    if (!metaFile) {
-        throw std::runtime_error("Não foi possível criar o arquivo de metadata: " + metadataPath.string());
-    }
-
-    metaFile << serializeKeyValue(content);
+    writeMetadataFile(content, metadataPath.string(), options.format);
 
     return MetadataCreationResult{content, metadataPath.string()};
 }
 
 MetadataContent loadMetadataFile(const std::string& metadataPath) {
-    std::ifstream input(metadataPath);
-    if (!input) {
-        throw std::runtime_error("Não foi possível abrir o arquivo de metadata: " + metadataPath);
+    MappedFile file(metadataPath);
+    if (isBinaryMetadata(file.data(), file.size())) {
+        // Arquivo local gerado por este programa: a raiz de Merkle não é recalculada
+        return parseBinary(file.data(), file.size(), false);
     }
-    return parseKeyValueStream(input);
+    return parseMetadataBuffer(file.data(), file.size());
 }
 
-MetadataContent parseMetadataString(const std::string& data) {
-    std::istringstream stream(data);
+MetadataContent parseMetadataBuffer(const void* data, std::size_t size) {
+    if (isBinaryMetadata(data, size)) {
+        return parseBinary(static_cast<const unsigned char*>(data), size, true);
+    }
+    std::istringstream stream(size > 0 ? std::string(static_cast<const char*>(data), size) : std::string());
     return parseKeyValueStream(stream);
 }
 
-std::string serializeMetadata(const MetadataContent& content) {
-    return serializeKeyValue(content);
+MetadataContent parseMetadataString(const std::string& data) {
+    return parseMetadataBuffer(data.data(), data.size());
+}
+
+std::string serializeMetadata(const MetadataContent& content, MetadataFormat format) {
+    return format == MetadataFormat::Binary ? serializeBinary(content) : serializeKeyValue(content);
+}
+
+void writeMetadataFile(const MetadataContent& content, const std::string& metadataPath, MetadataFormat format) {
+    std::ofstream metaFile(metadataPath, std::ios::binary | std::ios::trunc);
+    if (!metaFile) {
+        throw std::runtime_error("Não foi possível criar o arquivo de metadata: " + metadataPath);
+    }
+    metaFile << serializeMetadata(content, format);
+    if (!metaFile) {
+        throw std::runtime_error("Falha ao gravar o arquivo de metadata: " + metadataPath);
+    }
+}
+
+BlockHash hashBlock(const void* data, std::size_t size) {
+    return Sha256::hash(data, size);
+}
+
+BlockHash computeMerkleRoot(const std::vector<BlockHash>& leaves) {
+    if (leaves.empty()) {
+        return hashBlock(nullptr, 0);
+    }
+
+    // Cada nível combina pares de nós: pai = SHA-256(esquerdo || direito).
+    // Um nó sem par sobe sem alteração.
+    std::vector<BlockHash> level = leaves;
+    while (level.size() > 1) {
+        std::vector<BlockHash> parents;
+        parents.reserve((level.size() + 1) / 2);
+        for (std::size_t i = 0; i + 1 < level.size(); i += 2) {
+            unsigned char pair[2 * sizeof(BlockHash)];
+            std::memcpy(pair, level[i].data(), sizeof(BlockHash));
+            std::memcpy(pair + sizeof(BlockHash), level[i + 1].data(), sizeof(BlockHash));
+            parents.push_back(hashBlock(pair, sizeof(pair)));
+        }
+        if (level.size() % 2 != 0) {
+            parents.push_back(level.back());
+        }
+        level.swap(parents);
+    }
+    return level.front();
+}
+
+bool verifyBlock(const FileInfo& info, int blockIndex, const void* data, std::size_t size) {
+    if (info.blockHashes.empty()) {
+        return true; // Metadata sem hashes por bloco: só o checksum final é verificado
+    }
+    if (blockIndex < 0 || static_cast<std::size_t>(blockIndex) >= info.blockHashes.size()) {
+        return false;
+    }
+    return hashBlock(data, size) == info.blockHashes[static_cast<std::size_t>(blockIndex)];
 }
 
 std::string computeFileChecksum(const std::string& filePath) {
@@ -324,7 +613,7 @@ std::string computeFileChecksum(const std::string& filePath) {
     }
 
     Sha256 sha;
-    std::array<char, 4096> buffer;
+    std::vector<char> buffer(1 << 20);
     while (input) {
         input.read(buffer.data(), buffer.size());
         std::streamsize readBytes = input.gcount();
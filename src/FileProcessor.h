@@ -3,6 +3,7 @@
 
 #include <cstddef>
 #include <string>
+#include <vector>
 
 #include "FileMetadata.h"
 
@@ -10,24 +11,51 @@ namespace FileProcessor {
 
 struct MetadataContent {
     FileInfo info;
+    // Pasta com block_N.bin; vazia quando os blocos não foram gerados
     std::string blocksDirectory;
+    // Arquivo original, servido diretamente pelo seeder; vazio em metadata antiga
+    std::string sourceFile;
 };
 
+// Formato do arquivo .meta: binário (padrão, ver BinaryMetadata.h) ou o texto
+// key=value original, que continua sendo lido
+enum class MetadataFormat { Binary, Text };
+
 struct MetadataCreationResult {
     MetadataContent content;
     std::string metadataPath;
 };
 
+struct MetadataOptions {
+    std::string blocksRoot = "blocks";
+    std::string metadataRoot = "metadata";
+    // Grava também as cópias block_N.bin (o seeder serve direto do arquivo original)
+    bool writeBlockFiles = false;
+    // Threads que leem e calculam os hashes dos blocos; 0 usa todos os núcleos
+    unsigned threads = 0;
+    MetadataFormat format = MetadataFormat::Binary;
+};
+
+// Lê o arquivo uma vez calculando os hashes por bloco e o checksum.
+// A metadata aponta para o arquivo original.
 MetadataCreationResult createFileMetadata(const std::string& sourceFile,
                                           std::size_t blockSize,
-                                          const std::string& blocksRoot = "blocks",
-                                          const std::string& metadataRoot = "metadata");
+                                          const MetadataOptions& options = MetadataOptions());
 
+// Os leitores reconhecem os dois formatos pelo início do conteúdo
 MetadataContent loadMetadataFile(const std::string& metadataPath);
+MetadataContent parseMetadataBuffer(const void* data, std::size_t size);
 MetadataContent parseMetadataString(const std::string& data);
-std::string serializeMetadata(const MetadataContent& content);
+std::string serializeMetadata(const MetadataContent& content, MetadataFormat format = MetadataFormat::Binary);
+void writeMetadataFile(const MetadataContent& content, const std::string& metadataPath,
+                       MetadataFormat format = MetadataFormat::Binary);
 std::string computeFileChecksum(const std::string& filePath);
 
+BlockHash hashBlock(const void* data, std::size_t size);
+BlockHash computeMerkleRoot(const std::vector<BlockHash>& leaves);
+// Confere o bloco com o hash registrado na metadata (sempre verdadeiro sem hashes por bloco)
+bool verifyBlock(const FileInfo& info, int blockIndex, const void* data, std::size_t size);
+
 }
 
 #endif
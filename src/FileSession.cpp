@@ -0,0 +1,63 @@
+#include "FileSession.h"
+
+#include <stdexcept>
+
+int FileSession::findNextMissingBlock() const {
+    std::size_t missing = ownedBlocks.findFirstZero();
+    return missing == AtomicBitmap::npos ? -1 : static_cast<int>(missing);
+}
+
+std::string FileSession::idFromChecksum(const std::string& checksum) {
+    if (checksum.size() != idSize * 2) {
+        throw std::runtime_error("Identificador de arquivo inválido: " + checksum);
+    }
+    auto value = [&checksum](char c) {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        throw std::runtime_error("Identificador de arquivo inválido: " + checksum);
+    };
+    std::string id(idSize, '\0');
+    for (std::size_t i = 0; i < idSize; ++i) {
+        id[i] = static_cast<char>((value(checksum[i * 2]) << 4) | value(checksum[i * 2 + 1]));
+    }
+    return id;
+}
+
+FileSession& SessionRegistry::add(std::unique_ptr<FileSession> session) {
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    auto existing = byId.find(session->id);
+    if (existing != byId.end()) {
+        return *existing->second;
+    }
+    session->number = static_cast<std::uint32_t>(sessions.size());
+    FileSession* published = session.get();
+    byId.emplace(published->id, published);
+    sessions.push_back(std::move(session));
+    return *published;
+}
+
+FileSession* SessionRegistry::find(const std::string& id) const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    auto it = byId.find(id);
+    return it == byId.end() ? nullptr : it->second;
+}
+
+FileSession* SessionRegistry::first() const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return sessions.empty() ? nullptr : sessions.front().get();
+}
+
+std::vector<FileSession*> SessionRegistry::all() const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    std::vector<FileSession*> result;
+    for (const auto& session : sessions) {
+        result.push_back(session.get());
+    }
+    return result;
+}
+
+std::size_t SessionRegistry::size() const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return sessions.size();
+}
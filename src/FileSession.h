@@ -0,0 +1,93 @@
+#ifndef FILE_SESSION_H
+#define FILE_SESSION_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "AtomicBitmap.h"
+#include "BlockJournal.h"
+#include "DownloadScheduler.h"
+#include "EventServer.h"
+#include "FileProcessor.h"
+#include "FileStorage.h"
+#include "Protocol.h"
+
+// Estado de um arquivo compartilhado pelo peer: metadata, blocos possuídos,
+// armazenamento, diário e distribuição do download. Um peer mantém uma sessão
+// por arquivo; servidor, pool de conexões e E/S de disco são comuns a todas.
+struct FileSession {
+    // O identificador é o checksum SHA-256 do conteúdo, em bytes
+    static constexpr std::size_t idSize = Protocol::FILE_ID_SIZE;
+
+    std::string id;
+    // Número da sessão no registro, usado em chaves compactas (cache de blocos)
+    std::uint32_t number = 0;
+
+    FileInfo fileInfo;
+    // Indica que fileInfo/metadata já podem ser lidos pelas threads do servidor
+    std::atomic<bool> metadataReady { false };
+    // Falso quando o arquivo está completo e conferido (ou é servido pelo seeder)
+    std::atomic<bool> downloading { true };
+    // Blocos que o peer possui; lido sem lock pelas threads do servidor
+    AtomicBitmap ownedBlocks;
+
+    std::optional<FileProcessor::MetadataContent> localMetadata;
+    std::optional<FileProcessor::MetadataContent> remoteMetadata;
+    // Resposta de GET_METADATA já serializada (pronta antes de metadataReady)
+    std::vector<std::uint8_t> metadataPayload;
+    // Arquivo com os blocos: o original no seeder, o destino do download no leecher
+    FileStorage fileStorage;
+    // Blocos já sincronizados em fileStorage, para retomar após uma queda
+    BlockJournal journal;
+    // O lote do diário encheu: a thread do diário grava o mapa (flushJournal)
+    std::atomic<bool> journalFlushDue { false };
+    DownloadScheduler scheduler;
+
+    // Conexões que pediram BITFIELD deste arquivo e recebem HAVE a cada bloco novo.
+    // haveMutex ordena o envio do mapa em relação aos anúncios.
+    std::mutex haveMutex;
+    std::vector<std::weak_ptr<EventServer::Connection>> haveSubscribers;
+
+    std::mutex assembleMutex;
+    bool fileAssembled = false;
+
+    bool hasBlock(int blockIndex) const {
+        return blockIndex >= 0 && ownedBlocks.test(static_cast<std::size_t>(blockIndex));
+    }
+    bool hasAllBlocks() const { return ownedBlocks.size() > 0 && ownedBlocks.all(); }
+    int findNextMissingBlock() const;
+
+    // Converte o checksum em hexadecimal (metadata, linha de comando) no identificador
+    static std::string idFromChecksum(const std::string& checksum);
+};
+
+// Sessões publicadas (com metadata), indexadas pelo identificador. As threads do
+// servidor consultam o registro a cada pedido; sessões nunca são removidas, então
+// os ponteiros devolvidos valem enquanto o registro existir.
+class SessionRegistry {
+public:
+    // Publica a sessão. Se já houver uma com o mesmo identificador, ela é mantida
+    // e devolvida no lugar da nova.
+    FileSession& add(std::unique_ptr<FileSession> session);
+
+    FileSession* find(const std::string& id) const;
+    // A primeira sessão publicada: atende os pedidos sem identificador
+    FileSession* first() const;
+    std::vector<FileSession*> all() const;
+    std::size_t size() const;
+
+private:
+    mutable std::shared_mutex mutex;
+    std::vector<std::unique_ptr<FileSession>> sessions;
+    std::unordered_map<std::string, FileSession*> byId;
+};
+
+#endif
@@ -0,0 +1,89 @@
+#include "FileStorage.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/stat.h>
+#include <unistd.h>
+
+void FileStorage::open(const std::string& path, long long size, int blockLength) {
+    if (size < 0 || blockLength <= 0) {
+        throw std::runtime_error("Tamanho de arquivo ou de bloco inválido para " + path);
+    }
+
+    auto fd = std::make_shared<FileDescriptor>(::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644));
+    if (!fd->valid()) {
+        throw std::runtime_error("Não foi possível abrir o arquivo de destino " + path + ": " +
+                                 std::strerror(errno));
+    }
+
+    // Reserva o espaço de uma vez: evita fragmentação e falta de espaço no meio do download.
+    // Sistemas de arquivos sem fallocate recebem apenas o tamanho final.
+    if (size > 0 && fallocate(fd->get(), 0, 0, static_cast<off_t>(size)) < 0) {
+        if (errno != EOPNOTSUPP && errno != ENOSYS) {
+            throw std::runtime_error("Falha ao reservar espaço para " + path + ": " + std::strerror(errno));
+        }
+        if (ftruncate(fd->get(), static_cast<off_t>(size)) < 0) {
+            throw std::runtime_error("Falha ao definir o tamanho de " + path + ": " + std::strerror(errno));
+        }
+    }
+
+    descriptor = std::move(fd);
+    filePath = path;
+    fileSize = size;
+    blockSize = blockLength;
+}
+
+void FileStorage::openExisting(const std::string& path, long long size, int blockLength) {
+    if (size < 0 || blockLength <= 0) {
+        throw std::runtime_error("Tamanho de arquivo ou de bloco inválido para " + path);
+    }
+
+    auto fd = std::make_shared<FileDescriptor>(::open(path.c_str(), O_RDONLY | O_CLOEXEC));
+    if (!fd->valid()) {
+        throw std::runtime_error("Não foi possível abrir o arquivo " + path + ": " + std::strerror(errno));
+    }
+
+    struct stat fileStat{};
+    if (fstat(fd->get(), &fileStat) < 0) {
+        throw std::runtime_error("Falha ao consultar " + path + ": " + std::strerror(errno));
+    }
+    if (static_cast<long long>(fileStat.st_size) != size) {
+        throw std::runtime_error("O arquivo " + path + " tem " + std::to_string(fileStat.st_size) +
+                                 " bytes, mas a metadata registra " + std::to_string(size));
+    }
+
+    descriptor = std::move(fd);
+    filePath = path;
+    fileSize = size;
+    blockSize = blockLength;
+}
+
+off_t FileStorage::blockOffset(int blockIndex) const {
+    return static_cast<off_t>(blockIndex) * blockSize;
+}
+
+std::size_t FileStorage::blockLength(int blockIndex) const {
+    long long offset = static_cast<long long>(blockIndex) * blockSize;
+    if (blockIndex < 0 || offset >= fileSize) {
+        return 0;
+    }
+    return static_cast<std::size_t>(std::min<long long>(blockSize, fileSize - offset));
+}
+
+void FileStorage::sync() {
+    if (isOpen() && fdatasync(descriptor->get()) < 0) {
+        throw std::runtime_error("Falha ao sincronizar " + filePath + ": " + std::strerror(errno));
+    }
+}
+
+void FileStorage::rename(const std::string& newPath) {
+    if (std::rename(filePath.c_str(), newPath.c_str()) != 0) {
+        throw std::runtime_error("Falha ao renomear " + filePath + " para " + newPath + ": " +
+                                 std::strerror(errno));
+    }
+    filePath = newPath;
+}
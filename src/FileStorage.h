@@ -0,0 +1,44 @@
+#ifndef FILE_STORAGE_H
+#define FILE_STORAGE_H
+
+#include <sys/types.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "FileDescriptor.h"
+
+// Arquivo com todos os blocos de um compartilhamento, cada um na sua posição
+// (índice * tamanho do bloco). No leecher é o destino do download, com o tamanho
+// final reservado na abertura; no seeder é o próprio arquivo original.
+class FileStorage {
+public:
+    // Abre (ou cria) o arquivo e reserva fileSize bytes com fallocate
+    void open(const std::string& path, long long fileSize, int blockSize);
+    // Abre um arquivo completo só para leitura (seeder servindo o arquivo original);
+    // falha se o tamanho não for o registrado na metadata
+    void openExisting(const std::string& path, long long fileSize, int blockSize);
+    bool isOpen() const { return descriptor && descriptor->valid(); }
+
+    off_t blockOffset(int blockIndex) const;
+    std::size_t blockLength(int blockIndex) const;
+
+    // Garante que os dados gravados chegaram ao disco
+    void sync();
+    // Renomeia o arquivo no disco; o descritor aberto continua válido
+    void rename(const std::string& newPath);
+
+    const std::string& path() const { return filePath; }
+    // Compartilhado com os envios via sendfile ainda pendentes
+    const std::shared_ptr<FileDescriptor>& fd() const { return descriptor; }
+
+private:
+    std::shared_ptr<FileDescriptor> descriptor;
+    std::string filePath;
+    long long fileSize = 0;
+    int blockSize = 0;
+};
+
+#endif
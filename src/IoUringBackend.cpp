@@ -0,0 +1,305 @@
+#include "IoUringBackend.h"
+
+#include "Log.h"
+
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+// user_data da operação de poll no eventfd; as demais carregam o Request*
+constexpr std::uint64_t wakeToken = 0;
+
+int ringSetup(unsigned entries, io_uring_params* params) {
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+int ringEnter(int fd, unsigned toSubmit, unsigned minComplete, unsigned flags) {
+    return static_cast<int>(syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags, nullptr, 0));
+}
+
+int ringRegister(int fd, unsigned opcode, void* arg, unsigned count) {
+    return static_cast<int>(syscall(__NR_io_uring_register, fd, opcode, arg, count));
+}
+
+template <typename T>
+T* at(void* base, std::uint32_t offset) {
+    return reinterpret_cast<T*>(static_cast<std::uint8_t*>(base) + offset);
+}
+
+}
+
+IoUringBackend::IoUringBackend(unsigned queueDepth) {
+    io_uring_params params{};
+    ringFd = ringSetup(std::max(queueDepth, 4u), &params);
+    if (ringFd < 0) {
+        throw std::runtime_error(std::string("io_uring indisponível: ") + std::strerror(errno));
+    }
+
+    try {
+        sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool singleMap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (singleMap) {
+            sqRingSize = cqRingSize = std::max(sqRingSize, cqRingSize);
+        }
+
+        sqRing = mmap(nullptr, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd,
+                      IORING_OFF_SQ_RING);
+        if (sqRing == MAP_FAILED) {
+            sqRing = nullptr;
+            throw std::runtime_error(std::string("falha ao mapear o anel do io_uring: ") + std::strerror(errno));
+        }
+        if (singleMap) {
+            cqRing = sqRing;
+        } else {
+            cqRing = mmap(nullptr, cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd,
+                          IORING_OFF_CQ_RING);
+            if (cqRing == MAP_FAILED) {
+                cqRing = nullptr;
+                throw std::runtime_error(std::string("falha ao mapear o anel do io_uring: ") + std::strerror(errno));
+            }
+        }
+        sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+        void* sqeMap = mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd,
+                            IORING_OFF_SQES);
+        if (sqeMap == MAP_FAILED) {
+            throw std::runtime_error(std::string("falha ao mapear as SQEs do io_uring: ") + std::strerror(errno));
+        }
+        sqes = static_cast<io_uring_sqe*>(sqeMap);
+
+        sqHead = at<unsigned>(sqRing, params.sq_off.head);
+        sqTail = at<unsigned>(sqRing, params.sq_off.tail);
+        sqMask = *at<unsigned>(sqRing, params.sq_off.ring_mask);
+        sqEntries = *at<unsigned>(sqRing, params.sq_off.ring_entries);
+        sqArray = at<unsigned>(sqRing, params.sq_off.array);
+        cqHead = at<unsigned>(cqRing, params.cq_off.head);
+        cqTail = at<unsigned>(cqRing, params.cq_off.tail);
+        cqMask = *at<unsigned>(cqRing, params.cq_off.ring_mask);
+        cqes = at<io_uring_cqe>(cqRing, params.cq_off.cqes);
+
+        // READ/WRITE exigem kernel 5.6; kernels mais antigos ficam com o pool de threads
+        constexpr unsigned probeOps = 256;
+        std::vector<std::uint8_t> probeMemory(sizeof(io_uring_probe) + probeOps * sizeof(io_uring_probe_op));
+        auto* probe = reinterpret_cast<io_uring_probe*>(probeMemory.data());
+        if (ringRegister(ringFd, IORING_REGISTER_PROBE, probe, probeOps) < 0) {
+            throw std::runtime_error(std::string("io_uring sem IORING_REGISTER_PROBE: ") + std::strerror(errno));
+        }
+        for (unsigned op : {IORING_OP_READ, IORING_OP_WRITE, IORING_OP_POLL_ADD}) {
+            if (op > probe->last_op || !(probe->ops[op].flags & IO_URING_OP_SUPPORTED)) {
+                throw std::runtime_error("io_uring sem suporte à operação " + std::to_string(op));
+            }
+        }
+
+        wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (wakeFd < 0) {
+            throw std::runtime_error(std::string("falha ao criar eventfd: ") + std::strerror(errno));
+        }
+    } catch (...) {
+        releaseRing();
+        throw;
+    }
+
+    ringThread = std::thread(&IoUringBackend::ringLoop, this);
+}
+
+IoUringBackend::~IoUringBackend() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    std::uint64_t one = 1;
+    ssize_t ignored = ::write(wakeFd, &one, sizeof(one));
+    (void)ignored;
+    ringThread.join();
+    releaseRing();
+}
+
+void IoUringBackend::releaseRing() {
+    if (sqes) {
+        munmap(sqes, sqesSize);
+    }
+    if (cqRing && cqRing != sqRing) {
+        munmap(cqRing, cqRingSize);
+    }
+    if (sqRing) {
+        munmap(sqRing, sqRingSize);
+    }
+    if (wakeFd >= 0) {
+        close(wakeFd);
+    }
+    if (ringFd >= 0) {
+        close(ringFd);
+    }
+    sqes = nullptr;
+    sqRing = cqRing = nullptr;
+    wakeFd = ringFd = -1;
+}
+
+void IoUringBackend::read(int fd, void* buffer, std::size_t length, off_t offset, Completion done) {
+    submit(false, fd, static_cast<std::uint8_t*>(buffer), length, offset, std::move(done));
+}
+
+void IoUringBackend::write(int fd, const void* buffer, std::size_t length, off_t offset, Completion done) {
+    submit(true, fd, static_cast<std::uint8_t*>(const_cast<void*>(buffer)), length, offset, std::move(done));
+}
+
+void IoUringBackend::submit(bool write, int fd, std::uint8_t* buffer, std::size_t length, off_t offset,
+                            Completion done) {
+    operations.fetch_add(1, std::memory_order_relaxed);
+    if (length == 0) {
+        done(0);
+        return;
+    }
+
+    bool wake = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::unique_ptr<Request> request;
+        if (freeRequests.empty()) {
+            request = std::make_unique<Request>();
+        } else {
+            request = std::move(freeRequests.back());
+            freeRequests.pop_back();
+        }
+        *request = Request{write, fd, buffer, length, offset, 0, std::move(done)};
+        submitted.push_back(request.release());
+        // Um único aviso por volta do anel, por mais pedidos que cheguem nela
+        wake = !wakePending;
+        wakePending = true;
+    }
+    if (wake) {
+        std::uint64_t one = 1;
+        ssize_t ignored = ::write(wakeFd, &one, sizeof(one));
+        (void)ignored;
+    }
+}
+
+void IoUringBackend::finish(Request* request, ssize_t result) {
+    std::unique_ptr<Request> finished(request);
+    Completion completion = std::move(finished->completion);
+    finished->completion = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        freeRequests.push_back(std::move(finished));
+    }
+    completion(result);
+}
+
+void IoUringBackend::ringLoop() {
+    std::deque<Request*> backlog;
+    unsigned active = 0;
+    bool pollArmed = false;
+
+    while (true) {
+        bool stop;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            backlog.insert(backlog.end(), submitted.begin(), submitted.end());
+            submitted.clear();
+            wakePending = false;
+            stop = stopping;
+        }
+
+        // Só esta thread escreve na cauda da SQ; a cabeça é avançada pelo kernel
+        unsigned tail = *sqTail;
+        unsigned head = __atomic_load_n(sqHead, __ATOMIC_ACQUIRE);
+        auto nextSqe = [&]() {
+            unsigned index = tail & sqMask;
+            io_uring_sqe* sqe = &sqes[index];
+            std::memset(sqe, 0, sizeof(*sqe));
+            sqArray[index] = index;
+            ++tail;
+            return sqe;
+        };
+
+        if (!pollArmed && tail - head < sqEntries) {
+            io_uring_sqe* sqe = nextSqe();
+            sqe->opcode = IORING_OP_POLL_ADD;
+            sqe->fd = wakeFd;
+            sqe->poll32_events = POLLIN;
+            sqe->user_data = wakeToken;
+            pollArmed = true;
+        }
+        // Uma vaga fica para o poll, então a CQ (o dobro da SQ) nunca transborda
+        while (!backlog.empty() && tail - head < sqEntries && active + 1 < sqEntries) {
+            Request* request = backlog.front();
+            backlog.pop_front();
+            io_uring_sqe* sqe = nextSqe();
+            sqe->opcode = request->write ? IORING_OP_WRITE : IORING_OP_READ;
+            sqe->fd = request->fd;
+            sqe->addr = reinterpret_cast<std::uint64_t>(request->buffer + request->done);
+            sqe->len = static_cast<std::uint32_t>(std::min<std::size_t>(request->length - request->done, 1u << 30));
+            sqe->off = static_cast<std::uint64_t>(request->offset) + request->done;
+            sqe->user_data = reinterpret_cast<std::uint64_t>(request);
+            ++active;
+        }
+        __atomic_store_n(sqTail, tail, __ATOMIC_RELEASE);
+
+        if (stop && active == 0 && backlog.empty()) {
+            break;
+        }
+
+        unsigned toSubmit = tail - __atomic_load_n(sqHead, __ATOMIC_ACQUIRE);
+        int entered = ringEnter(ringFd, toSubmit, 1, IORING_ENTER_GETEVENTS);
+        if (toSubmit > 0) {
+            submitCalls.fetch_add(1, std::memory_order_relaxed);
+        }
+        if (entered < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+            int error = errno;
+            Log::error("[Disco] io_uring_enter falhou: ", std::strerror(error));
+            while (!backlog.empty()) {
+                finish(backlog.front(), -error);
+                backlog.pop_front();
+            }
+        }
+
+        unsigned cqFirst = *cqHead;
+        unsigned cqLast = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+        for (unsigned i = cqFirst; i != cqLast; ++i) {
+            const io_uring_cqe& cqe = cqes[i & cqMask];
+            if (cqe.user_data == wakeToken) {
+                std::uint64_t value;
+                ssize_t ignored = ::read(wakeFd, &value, sizeof(value));
+                (void)ignored;
+                pollArmed = false;
+                continue;
+            }
+
+            auto* request = reinterpret_cast<Request*>(cqe.user_data);
+            --active;
+            if (cqe.res == -EAGAIN || cqe.res == -EINTR) {
+                backlog.push_front(request);
+            } else if (cqe.res < 0) {
+                finish(request, cqe.res);
+            } else {
+                // Transferência parcial: o restante volta para o próximo lote
+                request->done += static_cast<std::size_t>(cqe.res);
+                if (cqe.res == 0 || request->done == request->length) {
+                    finish(request, static_cast<ssize_t>(request->done));
+                } else {
+                    backlog.push_front(request);
+                }
+            }
+        }
+        __atomic_store_n(cqHead, cqLast, __ATOMIC_RELEASE);
+    }
+}
+
+StorageBackend::Stats IoUringBackend::stats() const {
+    Stats result;
+    result.operations = operations.load(std::memory_order_relaxed);
+    result.submitCalls = submitCalls.load(std::memory_order_relaxed);
+    return result;
+}
@@ -0,0 +1,85 @@
+#ifndef IO_URING_BACKEND_H
+#define IO_URING_BACKEND_H
+
+#include <linux/io_uring.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "StorageBackend.h"
+
+// StorageBackend sobre io_uring, usando as syscalls diretamente (sem liburing).
+// Uma única thread é dona do anel: a cada volta ela coloca no anel tudo o que
+// foi submetido desde a anterior, envia o lote com um só io_uring_enter e
+// entrega as conclusões. As outras threads só enfileiram e, se preciso, acordam
+// o anel por um eventfd que fica registrado nele como uma operação de poll.
+class IoUringBackend : public StorageBackend {
+public:
+    // Lança std::runtime_error se o kernel não tiver io_uring ou as operações usadas
+    explicit IoUringBackend(unsigned queueDepth);
+    ~IoUringBackend() override;
+
+    IoUringBackend(const IoUringBackend&) = delete;
+    IoUringBackend& operator=(const IoUringBackend&) = delete;
+
+    void read(int fd, void* buffer, std::size_t length, off_t offset, Completion done) override;
+    void write(int fd, const void* buffer, std::size_t length, off_t offset, Completion done) override;
+
+    const char* name() const override { return "io_uring"; }
+    Stats stats() const override;
+
+private:
+    struct Request {
+        bool write;
+        int fd;
+        std::uint8_t* buffer;
+        std::size_t length;
+        off_t offset;
+        std::size_t done;
+        Completion completion;
+    };
+
+    int ringFd = -1;
+    int wakeFd = -1;
+
+    // Regiões mapeadas do anel de submissão (SQ), de conclusão (CQ) e das SQEs
+    void* sqRing = nullptr;
+    std::size_t sqRingSize = 0;
+    void* cqRing = nullptr;
+    std::size_t cqRingSize = 0;
+    io_uring_sqe* sqes = nullptr;
+    std::size_t sqesSize = 0;
+
+    unsigned* sqHead = nullptr;
+    unsigned* sqTail = nullptr;
+    unsigned* sqArray = nullptr;
+    unsigned sqMask = 0;
+    unsigned sqEntries = 0;
+    unsigned* cqHead = nullptr;
+    unsigned* cqTail = nullptr;
+    unsigned cqMask = 0;
+    io_uring_cqe* cqes = nullptr;
+
+    std::mutex mutex;
+    std::vector<Request*> submitted;
+    // Requests já concluídos, reaproveitados para não alocar um por operação
+    std::vector<std::unique_ptr<Request>> freeRequests;
+    bool wakePending = false;
+    bool stopping = false;
+    std::thread ringThread;
+
+    std::atomic<std::uint64_t> operations { 0 };
+    std::atomic<std::uint64_t> submitCalls { 0 };
+
+    void submit(bool write, int fd, std::uint8_t* buffer, std::size_t length, off_t offset, Completion done);
+    void finish(Request* request, ssize_t result);
+    void ringLoop();
+    void releaseRing();
+};
+
+#endif
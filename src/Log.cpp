@@ -0,0 +1,225 @@
+#include "Log.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Log {
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Espera máxima da thread de gravação; Warn/Error e anéis cheios a acordam antes
+constexpr std::chrono::milliseconds writerInterval { 20 };
+
+struct Entry {
+    Level level = Level::Info;
+    Clock::time_point time;
+    std::string text;
+};
+
+// Fila circular de um produtor (a thread dona) e um consumidor (quem drena,
+// sob drainMutex). head e tail só crescem; a posição é o resto da divisão.
+struct Ring {
+    static constexpr std::size_t capacity = 1024;
+
+    std::array<Entry, capacity> entries;
+    alignas(64) std::atomic<std::size_t> head { 0 };
+    alignas(64) std::atomic<std::size_t> tail { 0 };
+    // A thread dona terminou: o anel é descartado depois de esvaziado
+    std::atomic<bool> orphaned { false };
+
+    // Retorna a ocupação depois da inserção, ou 0 se o anel estava cheio
+    std::size_t push(Level level, std::string&& text) {
+        std::size_t position = tail.load(std::memory_order_relaxed);
+        std::size_t used = position - head.load(std::memory_order_acquire);
+        if (used == capacity) {
+            return 0;
+        }
+        Entry& entry = entries[position % capacity];
+        entry.level = level;
+        entry.time = Clock::now();
+        entry.text = std::move(text);
+        tail.store(position + 1, std::memory_order_release);
+        return used + 1;
+    }
+
+    bool empty() const {
+        return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+    }
+
+    void popAll(std::vector<Entry>& out) {
+        std::size_t position = head.load(std::memory_order_relaxed);
+        std::size_t end = tail.load(std::memory_order_acquire);
+        for (; position != end; ++position) {
+            out.push_back(std::move(entries[position % capacity]));
+        }
+        head.store(position, std::memory_order_release);
+    }
+};
+
+class Writer {
+public:
+    Writer() : thread(&Writer::run, this) {}
+
+    ~Writer() {
+        {
+            std::lock_guard<std::mutex> lock(wakeMutex);
+            stopping = true;
+        }
+        wakeCondition.notify_one();
+        thread.join();
+        drain();
+    }
+
+    std::shared_ptr<Ring> registerRing() {
+        auto ring = std::make_shared<Ring>();
+        std::lock_guard<std::mutex> lock(ringsMutex);
+        rings.push_back(ring);
+        return ring;
+    }
+
+    void wake() {
+        {
+            std::lock_guard<std::mutex> lock(wakeMutex);
+            wakeRequested = true;
+        }
+        wakeCondition.notify_one();
+    }
+
+    void countDropped() { dropped.fetch_add(1, std::memory_order_relaxed); }
+
+    void drain() {
+        std::lock_guard<std::mutex> drainLock(drainMutex);
+        batch.clear();
+        {
+            std::lock_guard<std::mutex> lock(ringsMutex);
+            for (auto it = rings.begin(); it != rings.end();) {
+                // orphaned é lido antes de esvaziar: nada mais chega depois dele
+                bool finished = (*it)->orphaned.load(std::memory_order_acquire);
+                (*it)->popAll(batch);
+                it = finished ? rings.erase(it) : std::next(it);
+            }
+        }
+
+        // Os anéis são drenados um de cada vez; o horário refaz a ordem entre threads
+        std::stable_sort(batch.begin(), batch.end(),
+                         [](const Entry& a, const Entry& b) { return a.time < b.time; });
+        std::string out;
+        std::string err;
+        for (const auto& entry : batch) {
+            std::string& target = entry.level >= Level::Warn ? err : out;
+            target += entry.text;
+            target += '\n';
+        }
+        std::uint64_t lost = dropped.exchange(0, std::memory_order_relaxed);
+        if (lost > 0) {
+            err += "[Log] " + std::to_string(lost) + " mensagem(ns) descartada(s): fila cheia\n";
+        }
+
+        if (!out.empty()) {
+            std::fwrite(out.data(), 1, out.size(), stdout);
+            std::fflush(stdout);
+        }
+        if (!err.empty()) {
+            std::fwrite(err.data(), 1, err.size(), stderr);
+            std::fflush(stderr);
+        }
+    }
+
+private:
+    std::mutex ringsMutex;
+    std::vector<std::shared_ptr<Ring>> rings;
+
+    // Um único consumidor por vez em cada anel
+    std::mutex drainMutex;
+    std::vector<Entry> batch;
+    std::atomic<std::uint64_t> dropped { 0 };
+
+    std::mutex wakeMutex;
+    std::condition_variable wakeCondition;
+    bool wakeRequested = false;
+    bool stopping = false;
+    std::thread thread;
+
+    void run() {
+        std::unique_lock<std::mutex> lock(wakeMutex);
+        while (!stopping) {
+            wakeCondition.wait_for(lock, writerInterval, [this] { return wakeRequested || stopping; });
+            wakeRequested = false;
+            lock.unlock();
+            drain();
+            lock.lock();
+        }
+    }
+};
+
+Writer& writer() {
+    static Writer instance;
+    return instance;
+}
+
+// Anel da thread atual, registrado na primeira mensagem
+struct LocalRing {
+    std::shared_ptr<Ring> ring;
+
+    ~LocalRing() {
+        if (ring) {
+            ring->orphaned.store(true, std::memory_order_release);
+        }
+    }
+};
+
+thread_local LocalRing localRing;
+
+} // namespace
+
+void setLevel(Level level) {
+    detail::threshold.store(static_cast<int>(level), std::memory_order_relaxed);
+}
+
+Level level() {
+    return static_cast<Level>(detail::threshold.load(std::memory_order_relaxed));
+}
+
+bool parseLevel(const std::string& name, Level& level) {
+    if (name == "debug") {
+        level = Level::Debug;
+    } else if (name == "info") {
+        level = Level::Info;
+    } else if (name == "warn") {
+        level = Level::Warn;
+    } else if (name == "error") {
+        level = Level::Error;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+void write(Level level, std::string text) {
+    Writer& target = writer();
+    if (!localRing.ring) {
+        localRing.ring = target.registerRing();
+    }
+
+    std::size_t used = localRing.ring->push(level, std::move(text));
+    if (used == 0) {
+        target.countDropped();
+        target.wake();
+    } else if (level >= Level::Warn || used == Ring::capacity / 2) {
+        target.wake();
+    }
+}
+
+void flush() {
+    writer().drain();
+}
+
+} // namespace Log
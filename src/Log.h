@@ -0,0 +1,59 @@
+#ifndef LOG_H
+#define LOG_H
+
+#include <atomic>
+#include <sstream>
+#include <string>
+#include <utility>
+
+// Log assíncrono. Cada thread escreve as mensagens em um anel próprio (um
+// produtor, um consumidor, sem lock) e uma thread de fundo as junta em ordem de
+// chegada e grava em stdout (Debug/Info) ou stderr (Warn/Error). Quem registra
+// não espera pelo terminal nem disputa o lock do stream com as outras threads.
+//
+// Abaixo do nível configurado a mensagem nem é formatada: o custo é a leitura
+// de um atômico. As mensagens por bloco ficam em Debug, desligado por padrão.
+namespace Log {
+
+enum class Level { Debug, Info, Warn, Error };
+
+void setLevel(Level level);
+Level level();
+// Aceita "debug", "info", "warn" e "error"
+bool parseLevel(const std::string& name, Level& level);
+
+namespace detail {
+inline std::atomic<int> threshold { static_cast<int>(Level::Info) };
+}
+
+inline bool enabled(Level level) {
+    return static_cast<int>(level) >= detail::threshold.load(std::memory_order_relaxed);
+}
+
+// Enfileira uma linha já formatada (sem o '\n' final)
+void write(Level level, std::string text);
+// Grava tudo o que já foi enfileirado antes de retornar
+void flush();
+
+template <typename... Args>
+void message(Level level, const Args&... args) {
+    if (!enabled(level)) {
+        return;
+    }
+    std::ostringstream out;
+    (out << ... << args);
+    write(level, out.str());
+}
+
+template <typename... Args>
+void debug(const Args&... args) { message(Level::Debug, args...); }
+template <typename... Args>
+void info(const Args&... args) { message(Level::Info, args...); }
+template <typename... Args>
+void warn(const Args&... args) { message(Level::Warn, args...); }
+template <typename... Args>
+void error(const Args&... args) { message(Level::Error, args...); }
+
+} // namespace Log
+
+#endif
@@ -0,0 +1,244 @@
+#include "Metrics.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <sstream>
+#include <utility>
+
+namespace {
+
+// Slot de shard desta thread, o mesmo em todas as instâncias. Atribuído em
+// rodízio no primeiro registro; SIZE_MAX enquanto a thread não registrou nada.
+std::atomic<std::size_t> nextShardSlot { 0 };
+thread_local std::size_t threadShardSlot = SIZE_MAX;
+
+std::size_t bucketFor(std::uint64_t micros) {
+    if (micros == 0) {
+        return 0;
+    }
+    std::size_t bucket = 64 - static_cast<std::size_t>(__builtin_clzll(micros));
+    return std::min(bucket, Metrics::bucketCount - 1);
+}
+
+std::uint64_t toMicros(std::chrono::steady_clock::duration elapsed) {
+    auto micros = std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+    return micros > 0 ? static_cast<std::uint64_t>(micros) : 0;
+}
+
+}
+
+std::uint64_t Metrics::Histogram::percentileMicros(double p) const {
+    if (count == 0) {
+        return 0;
+    }
+    auto target = static_cast<std::uint64_t>(p * static_cast<double>(count));
+    target = std::max<std::uint64_t>(target, 1);
+    std::uint64_t seen = 0;
+    for (std::size_t i = 0; i < bucketCount; ++i) {
+        if (buckets[i] == 0 || seen + buckets[i] < target) {
+            seen += buckets[i];
+            continue;
+        }
+        // Interpola dentro do balde, supondo as amostras espalhadas por ele
+        std::uint64_t low = i == 0 ? 0 : std::uint64_t{1} << (i - 1);
+        std::uint64_t high = std::uint64_t{1} << i;
+        double fraction = static_cast<double>(target - seen) / static_cast<double>(buckets[i]);
+        auto estimate = low + static_cast<std::uint64_t>(fraction * static_cast<double>(high - low));
+        return std::min(estimate, maxMicros);
+    }
+    return maxMicros;
+}
+
+void Metrics::Histogram::merge(const Histogram& other) {
+    count += other.count;
+    sumMicros += other.sumMicros;
+    maxMicros = std::max(maxMicros, other.maxMicros);
+    for (std::size_t i = 0; i < bucketCount; ++i) {
+        buckets[i] += other.buckets[i];
+    }
+}
+
+void Metrics::AtomicHistogram::record(std::uint64_t micros) {
+    count.fetch_add(1, std::memory_order_relaxed);
+    sumMicros.fetch_add(micros, std::memory_order_relaxed);
+    buckets[bucketFor(micros)].fetch_add(1, std::memory_order_relaxed);
+    std::uint64_t known = maxMicros.load(std::memory_order_relaxed);
+    while (micros > known && !maxMicros.compare_exchange_weak(known, micros, std::memory_order_relaxed)) {
+    }
+}
+
+Metrics::Histogram Metrics::AtomicHistogram::load() const {
+    Histogram copy;
+    copy.count = count.load(std::memory_order_relaxed);
+    copy.sumMicros = sumMicros.load(std::memory_order_relaxed);
+    copy.maxMicros = maxMicros.load(std::memory_order_relaxed);
+    for (std::size_t i = 0; i < bucketCount; ++i) {
+        copy.buckets[i] = buckets[i].load(std::memory_order_relaxed);
+    }
+    return copy;
+}
+
+Metrics::Metrics()
+    : started(std::chrono::steady_clock::now()), shards(new Shard[shardCount]) {
+    for (std::size_t i = 0; i < shardCount; ++i) {
+        shards[i].served.reset(new ServedTotals[1]);
+    }
+}
+
+Metrics::~Metrics() = default;
+
+void Metrics::setNeighbors(const std::vector<NeighborInfo>& neighbors) {
+    neighborSlots.clear();
+    for (const auto& neighbor : neighbors) {
+        auto slot = std::make_unique<NeighborSlot>();
+        slot->address = neighbor.ip + ":" + std::to_string(neighbor.port);
+        neighborSlots.push_back(std::move(slot));
+    }
+    for (std::size_t i = 0; i < shardCount; ++i) {
+        shards[i].served.reset(new ServedTotals[neighbors.size() + 1]);
+    }
+}
+
+Metrics::Shard& Metrics::localShard() {
+    if (threadShardSlot == SIZE_MAX) {
+        threadShardSlot = nextShardSlot.fetch_add(1, std::memory_order_relaxed) % shardCount;
+    }
+    return shards[threadShardSlot];
+}
+
+void Metrics::add(Counter counter, std::uint64_t amount) {
+    localShard().counters[static_cast<std::size_t>(counter)].fetch_add(amount, std::memory_order_relaxed);
+}
+
+void Metrics::record(Latency latency, std::chrono::steady_clock::duration elapsed) {
+    localShard().latencies[static_cast<std::size_t>(latency)].record(toMicros(elapsed));
+}
+
+void Metrics::recordFetch(std::size_t neighbor, std::size_t bytes, std::chrono::steady_clock::duration rtt) {
+    Shard& shard = localShard();
+    shard.counters[static_cast<std::size_t>(Counter::BlocksFetched)].fetch_add(1, std::memory_order_relaxed);
+    shard.latencies[static_cast<std::size_t>(Latency::BlockRtt)].record(toMicros(rtt));
+    if (neighbor < neighborSlots.size()) {
+        NeighborSlot& slot = *neighborSlots[neighbor];
+        slot.blocks.fetch_add(1, std::memory_order_relaxed);
+        slot.bytes.fetch_add(bytes, std::memory_order_relaxed);
+        slot.rtt.record(toMicros(rtt));
+    }
+}
+
+void Metrics::recordFetchError(std::size_t neighbor) {
+    localShard().counters[static_cast<std::size_t>(Counter::FetchErrors)].fetch_add(1, std::memory_order_relaxed);
+    if (neighbor < neighborSlots.size()) {
+        neighborSlots[neighbor]->errors.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void Metrics::recordServed(int neighbor, std::size_t bytes) {
+    Shard& shard = localShard();
+    shard.counters[static_cast<std::size_t>(Counter::BlocksServed)].fetch_add(1, std::memory_order_relaxed);
+    std::size_t index = neighbor >= 0 && static_cast<std::size_t>(neighbor) < neighborSlots.size()
+                            ? static_cast<std::size_t>(neighbor)
+                            : neighborSlots.size();
+    shard.served[index].blocks.fetch_add(1, std::memory_order_relaxed);
+    shard.served[index].bytes.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+Metrics::Snapshot Metrics::snapshot() const {
+    Snapshot result;
+    result.uptime = std::chrono::steady_clock::now() - started;
+
+    std::vector<NeighborStats> served(neighborSlots.size() + 1);
+    for (std::size_t i = 0; i < shardCount; ++i) {
+        const Shard& shard = shards[i];
+        for (std::size_t c = 0; c < result.counters.size(); ++c) {
+            result.counters[c] += shard.counters[c].load(std::memory_order_relaxed);
+        }
+        for (std::size_t l = 0; l < result.latencies.size(); ++l) {
+            result.latencies[l].merge(shard.latencies[l].load());
+        }
+        for (std::size_t n = 0; n < served.size(); ++n) {
+            served[n].blocks += shard.served[n].blocks.load(std::memory_order_relaxed);
+            served[n].bytes += shard.served[n].bytes.load(std::memory_order_relaxed);
+        }
+    }
+
+    for (const auto& slot : neighborSlots) {
+        NeighborStats stats;
+        stats.address = slot->address;
+        stats.blocks = slot->blocks.load(std::memory_order_relaxed);
+        stats.bytes = slot->bytes.load(std::memory_order_relaxed);
+        stats.errors = slot->errors.load(std::memory_order_relaxed);
+        stats.rtt = slot->rtt.load();
+        result.fetchedFrom.push_back(std::move(stats));
+    }
+    for (std::size_t n = 0; n < served.size(); ++n) {
+        served[n].address = n < neighborSlots.size() ? neighborSlots[n]->address : "other";
+        if (served[n].blocks > 0) {
+            result.servedTo.push_back(std::move(served[n]));
+        }
+    }
+    return result;
+}
+
+namespace {
+
+void appendHistogram(std::ostringstream& out, const std::string& prefix, const Metrics::Histogram& histogram) {
+    char mean[32];
+    std::snprintf(mean, sizeof(mean), "%.1f", histogram.meanMicros());
+    out << prefix << "_count=" << histogram.count << "\n"
+        << prefix << "_mean_us=" << mean << "\n"
+        << prefix << "_p50_us=" << histogram.percentileMicros(0.50) << "\n"
+        << prefix << "_p99_us=" << histogram.percentileMicros(0.99) << "\n"
+        << prefix << "_max_us=" << histogram.maxMicros << "\n";
+}
+
+}
+
+std::string Metrics::format(const Snapshot& snapshot) {
+    std::ostringstream out;
+    out << "uptime_ms=" << std::chrono::duration_cast<std::chrono::milliseconds>(snapshot.uptime).count() << "\n";
+    for (std::size_t i = 0; i < snapshot.counters.size(); ++i) {
+        out << counterName(static_cast<Counter>(i)) << "=" << snapshot.counters[i] << "\n";
+    }
+    for (std::size_t i = 0; i < snapshot.latencies.size(); ++i) {
+        appendHistogram(out, latencyName(static_cast<Latency>(i)), snapshot.latencies[i]);
+    }
+    for (const auto& neighbor : snapshot.fetchedFrom) {
+        std::string prefix = "neighbor." + neighbor.address;
+        out << prefix << ".blocks=" << neighbor.blocks << "\n"
+            << prefix << ".bytes=" << neighbor.bytes << "\n"
+            << prefix << ".errors=" << neighbor.errors << "\n";
+        appendHistogram(out, prefix + ".rtt", neighbor.rtt);
+    }
+    for (const auto& client : snapshot.servedTo) {
+        std::string prefix = "client." + client.address;
+        out << prefix << ".blocks=" << client.blocks << "\n"
+            << prefix << ".bytes=" << client.bytes << "\n";
+    }
+    return out.str();
+}
+
+const char* Metrics::counterName(Counter counter) {
+    switch (counter) {
+        case Counter::BytesIn: return "bytes_in";
+        case Counter::BytesOut: return "bytes_out";
+        case Counter::BlocksServed: return "blocks_served";
+        case Counter::BlocksFetched: return "blocks_fetched";
+        case Counter::RequestErrors: return "request_errors";
+        case Counter::FetchErrors: return "fetch_errors";
+        case Counter::HashFailures: return "hash_failures";
+        case Counter::DuplicateBlocks: return "duplicate_blocks";
+        case Counter::Count: break;
+    }
+    return "?";
+}
+
+const char* Metrics::latencyName(Latency latency) {
+    switch (latency) {
+        case Latency::BlockRtt: return "block_rtt";
+        case Latency::DiskRead: return "disk_read";
+        case Latency::DiskWrite: return "disk_write";
+        case Latency::Count: break;
+    }
+    return "?";
+}
@@ -0,0 +1,149 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "NeighborInfo.h"
+
+// Métricas de um peer em tempo de execução: contadores, histogramas de latência
+// e totais por vizinho. Cada thread escreve em um shard (atômicos em cache lines
+// separadas, atualizados com memory_order_relaxed), então o registro não disputa
+// locks nem cache lines no caminho quente; snapshot() soma os shards. Os shards
+// são slots fixos: cada thread recebe um na primeira vez que registra algo, em
+// rodízio, e threads que terminam não deixam nada para trás. Duas threads no
+// mesmo slot só dividem a cache line, sem perder contagens.
+class Metrics {
+public:
+    enum class Counter {
+        BytesIn,
+        BytesOut,
+        BlocksServed,
+        BlocksFetched,
+        // Pedidos que o servidor não conseguiu atender (BLOCK_ERROR/ERROR enviados)
+        RequestErrors,
+        // Respostas de erro ou blocos inválidos recebidos dos vizinhos
+        FetchErrors,
+        HashFailures,
+        // Cópias de um bloco que chegaram depois da primeira (modo endgame)
+        DuplicateBlocks,
+        Count
+    };
+
+    enum class Latency {
+        // Do envio do REQUEST_BLOCK até a chegada do bloco
+        BlockRtt,
+        DiskRead,
+        DiskWrite,
+        Count
+    };
+
+    // Histograma em potências de 2 de microssegundos: o balde i conta as
+    // amostras em [2^(i-1), 2^i) us (o balde 0, as abaixo de 1 us)
+    static constexpr std::size_t bucketCount = 32;
+
+    struct Histogram {
+        std::uint64_t count = 0;
+        std::uint64_t sumMicros = 0;
+        std::uint64_t maxMicros = 0;
+        std::array<std::uint64_t, bucketCount> buckets {};
+
+        double meanMicros() const { return count ? static_cast<double>(sumMicros) / count : 0.0; }
+        // Percentil estimado por interpolação dentro do balde (0 < p <= 1)
+        std::uint64_t percentileMicros(double p) const;
+        void merge(const Histogram& other);
+    };
+
+    struct NeighborStats {
+        std::string address;
+        std::uint64_t blocks = 0;
+        std::uint64_t bytes = 0;
+        std::uint64_t errors = 0;
+        Histogram rtt;
+    };
+
+    struct Snapshot {
+        std::chrono::steady_clock::duration uptime {};
+        std::array<std::uint64_t, static_cast<std::size_t>(Counter::Count)> counters {};
+        std::array<Histogram, static_cast<std::size_t>(Latency::Count)> latencies {};
+        // Blocos baixados de cada vizinho configurado
+        std::vector<NeighborStats> fetchedFrom;
+        // Blocos servidos a cada vizinho configurado que se identificou no
+        // HANDSHAKE e, por último, aos demais clientes ("other")
+        std::vector<NeighborStats> servedTo;
+
+        std::uint64_t counter(Counter which) const { return counters[static_cast<std::size_t>(which)]; }
+        const Histogram& latency(Latency which) const { return latencies[static_cast<std::size_t>(which)]; }
+    };
+
+    Metrics();
+    ~Metrics();
+
+    Metrics(const Metrics&) = delete;
+    Metrics& operator=(const Metrics&) = delete;
+
+    // Define os vizinhos de quem os blocos são baixados; antes de as threads começarem
+    void setNeighbors(const std::vector<NeighborInfo>& neighbors);
+
+    void add(Counter counter, std::uint64_t amount = 1);
+    void record(Latency latency, std::chrono::steady_clock::duration elapsed);
+    void recordFetch(std::size_t neighbor, std::size_t bytes, std::chrono::steady_clock::duration rtt);
+    void recordFetchError(std::size_t neighbor);
+    // neighbor: índice do vizinho dono da conexão, -1 se desconhecido
+    void recordServed(int neighbor, std::size_t bytes);
+
+    Snapshot snapshot() const;
+    // Uma linha "chave=valor" por métrica (o payload da resposta STATS)
+    static std::string format(const Snapshot& snapshot);
+
+    static const char* counterName(Counter counter);
+    static const char* latencyName(Latency latency);
+
+private:
+    struct AtomicHistogram {
+        std::atomic<std::uint64_t> count { 0 };
+        std::atomic<std::uint64_t> sumMicros { 0 };
+        std::atomic<std::uint64_t> maxMicros { 0 };
+        std::array<std::atomic<std::uint64_t>, bucketCount> buckets {};
+
+        void record(std::uint64_t micros);
+        Histogram load() const;
+    };
+
+    struct ServedTotals {
+        std::atomic<std::uint64_t> blocks { 0 };
+        std::atomic<std::uint64_t> bytes { 0 };
+    };
+
+    struct alignas(64) Shard {
+        std::array<std::atomic<std::uint64_t>, static_cast<std::size_t>(Counter::Count)> counters {};
+        std::array<AtomicHistogram, static_cast<std::size_t>(Latency::Count)> latencies;
+        // Um total por vizinho e um último para os clientes desconhecidos
+        std::unique_ptr<ServedTotals[]> served;
+    };
+
+    static constexpr std::size_t shardCount = 32;
+
+    // Cada vizinho é atendido por um único worker, que é quem escreve aqui
+    struct alignas(64) NeighborSlot {
+        std::string address;
+        std::atomic<std::uint64_t> blocks { 0 };
+        std::atomic<std::uint64_t> bytes { 0 };
+        std::atomic<std::uint64_t> errors { 0 };
+        AtomicHistogram rtt;
+    };
+
+    const std::chrono::steady_clock::time_point started;
+    std::unique_ptr<Shard[]> shards;
+    std::vector<std::unique_ptr<NeighborSlot>> neighborSlots;
+
+    Shard& localShard();
+};
+
+#endif
@@ -0,0 +1,21 @@
+#ifndef NEIGHBOR_INFO_H
+#define NEIGHBOR_INFO_H
+
+#include <string>
+#include <tuple>
+
+// Estrutura para armazenar informações do vizinho
+struct NeighborInfo {
+    std::string ip;
+    int port;
+};
+
+inline bool operator==(const NeighborInfo& lhs, const NeighborInfo& rhs) {
+    return lhs.port == rhs.port && lhs.ip == rhs.ip;
+}
+
+inline bool operator<(const NeighborInfo& lhs, const NeighborInfo& rhs) {
+    return std::tie(lhs.ip, lhs.port) < std::tie(rhs.ip, rhs.port);
+}
+
+#endif
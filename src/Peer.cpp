@@ -1,452 +1,1248 @@
 #include "Peer.h"
 
+#include "Log.h"
 #include "Protocol.h"
 
 #include <algorithm>
 #include <arpa/inet.h>
 #include <cerrno>
 #include <cstring>
+#include <fcntl.h>
 #include <filesystem>
 #include <fstream>
-#include <iostream>
 #include <iterator>
+#include <poll.h>
+#include <stdexcept>
+#include <sys/stat.h>
 #include <unistd.h>
 #include <vector>
 
-// Tamanho do chunck armazenado pelo peer
-#define BUFFER_SIZE 1024
-
 // Construtor atualizado para aceitar uma lista de vizinhos e metadata opcional
-Peer::Peer(int myPort, const std::vector<NeighborInfo>& neighbors, std::string metadataPath)
+Peer::Peer(int myPort, const std::vector<NeighborInfo>& neighbors, std::string metadataPath,
+           PeerConfig config)
+    : Peer(myPort, neighbors,
+           metadataPath.empty() ? std::vector<std::string>{} : std::vector<std::string>{std::move(metadataPath)},
+           std::move(config)) {}
+
+Peer::Peer(int myPort, const std::vector<NeighborInfo>& neighbors, std::vector<std::string> metadataPaths,
+           PeerConfig config)
     : myPort(myPort),
+      config(std::move(config)),
       neighbors(neighbors),
       running(true),
-      metadataPath(std::move(metadataPath)),
-      downloadRoot("downloads") {
-    if (!this->metadataPath.empty()) {
+      metadataPaths(std::move(metadataPaths)),
+      downloadRoot(this->config.downloadRoot),
+      blockCache(this->config.blockCacheBytes),
+      uploads(this->config.uploadSlots, this->config.optimisticUnchokeRounds),
+      server(myPort, this->config.serverThreads,
+             [this](const EventServer::ConnectionPtr& connection, Protocol::MessageType type,
+                    const std::vector<std::uint8_t>& payload) {
+                 handleMessage(connection, type, payload);
+             }) {
+    if (this->config.pipelineWindow == 0) {
+        this->config.pipelineWindow = 1;
+    }
+    metrics.setNeighbors(neighbors);
+    diskIo = StorageBackend::create(this->config.ioBackend, this->config.ioThreads);
+    Log::info("[Peer ", myPort, "] E/S de disco: ", diskIo->name());
+    for (const auto& metadataPath : this->metadataPaths) {
+        try {
+            loadSeedSession(metadataPath);
+        } catch (const std::exception& e) {
+            Log::error("[Peer ", myPort, "] Falha ao carregar metadata: ", e.what());
+        }
+    }
+    if (!this->config.blockFiles) {
+        resumeDownloads();
+    }
+}
+
+void Peer::loadSeedSession(const std::string& metadataPath) {
+    auto session = std::make_unique<FileSession>();
+    session->localMetadata = FileProcessor::loadMetadataFile(metadataPath);
+    session->fileInfo = session->localMetadata->info;
+    session->id = FileSession::idFromChecksum(session->fileInfo.checksum);
+    openSeedSource(*session);
+    cacheMetadataPayload(*session, *session->localMetadata);
+    session->ownedBlocks.reset(static_cast<std::size_t>(session->fileInfo.blockCount), true);
+    session->downloading = false;
+    session->metadataReady = true;
+    sessions.add(std::move(session));
+    Log::info("[Peer ", myPort, "] Metadata local carregada de ", metadataPath);
+}
+
+void Peer::resumeDownloads() {
+    // Downloads interrompidos: downloads/<nome>/ com <nome>.meta e <nome>.journal
+    namespace fs = std::filesystem;
+    std::error_code error;
+    for (const auto& entry : fs::directory_iterator(downloadRoot, error)) {
+        std::string name = entry.path().filename().string();
+        if (!entry.is_directory(error) || !fs::exists(entry.path() / (name + ".meta"), error) ||
+            !fs::exists(entry.path() / (name + ".journal"), error)) {
+            continue;
+        }
         try {
-            localMetadata = FileProcessor::loadMetadataFile(this->metadataPath);
-            fileInfo = localMetadata->info;
-            ownedBlocks.assign(fileInfo.blockCount, true);
-            std::cout << "[Peer " << myPort << "] Metadata local carregada de " << this->metadataPath << "\n";
+            resumeDownload(entry.path());
         } catch (const std::exception& e) {
-            std::cerr << "[Peer " << myPort << "] Falha ao carregar metadata: " << e.what() << "\n";
+            Log::warn("[Peer ", myPort, "] Não foi possível retomar o download: ", e.what());
+        }
+    }
+}
+
+bool Peer::resumeDownload(const std::filesystem::path& targetDir) {
+    namespace fs = std::filesystem;
+    std::error_code error;
+    std::string name = targetDir.filename().string();
+    auto metadata = FileProcessor::loadMetadataFile((targetDir / (name + ".meta")).string());
+    const FileInfo& info = metadata.info;
+    if (info.fileName != name) {
+        throw std::runtime_error("metadata de " + targetDir.string() + " descreve outro arquivo");
+    }
+    std::string id = FileSession::idFromChecksum(info.checksum);
+    if (sessions.find(id)) {
+        return false; // O próprio peer já serve este arquivo
+    }
+
+    auto session = std::make_unique<FileSession>();
+    session->id = id;
+
+    // O .part ainda recebe blocos; sem ele, o download já terminou e foi renomeado
+    FileStorage& storage = session->fileStorage;
+    fs::path partialPath = targetDir / (name + ".part");
+    bool partial = fs::exists(partialPath, error);
+    if (partial) {
+        storage.open(partialPath.string(), info.fileSize, info.blockSize);
+    } else {
+        storage.openExisting((targetDir / name).string(), info.fileSize, info.blockSize);
+    }
+
+    BlockJournal& journal = session->journal;
+    journal.open((targetDir / (name + ".journal")).string(), info, config.journalBatch, config.journalInterval);
+    std::vector<bool> blocks = journal.recoveredBlocks();
+    if (config.verifyOnResume && !info.blockHashes.empty()) {
+        // Confere todos os blocos: também recupera os gravados depois do último flush
+        blocks = verifyStoredBlocks(storage, info);
+    }
+
+    std::size_t recovered = static_cast<std::size_t>(std::count(blocks.begin(), blocks.end(), true));
+    if (!partial && recovered != blocks.size()) {
+        throw std::runtime_error("o arquivo " + (targetDir / name).string() +
+                                 " não confere com o diário; remova-o para baixar de novo");
+    }
+    if (config.verifyOnResume && !info.blockHashes.empty()) {
+        journal.replace(blocks);
+        journal.flush([&storage] { storage.sync(); });
+    }
+
+    session->remoteMetadata = std::move(metadata);
+    session->fileInfo = session->remoteMetadata->info;
+    cacheMetadataPayload(*session, *session->remoteMetadata);
+    session->ownedBlocks.reset(blocks.size(), false);
+    for (std::size_t i = 0; i < blocks.size(); ++i) {
+        if (blocks[i]) {
+            session->ownedBlocks.set(i);
         }
     }
+    session->metadataReady = true;
+    FileSession& resumed = sessions.add(std::move(session));
+    Log::info("[Peer ", myPort, "] Download retomado de ", targetDir.string(), ": ", recovered, " de ",
+              blocks.size(), " blocos já salvos");
+
+    if (resumed.hasAllBlocks()) {
+        if (partial) {
+            tryAssembleFile(resumed);
+        } else {
+            std::lock_guard<std::mutex> lock(resumed.assembleMutex);
+            resumed.fileAssembled = true;
+            resumed.downloading = false;
+        }
+    }
+    return true;
+}
+
+std::vector<bool> Peer::verifyStoredBlocks(const FileStorage& storage, const FileInfo& info) const {
+    std::size_t blockCount = static_cast<std::size_t>(info.blockCount);
+    std::vector<std::uint8_t> valid(blockCount, 0);
+    std::atomic<std::size_t> nextBlock { 0 };
+
+    auto worker = [&] {
+        std::vector<std::uint8_t> buffer(static_cast<std::size_t>(info.blockSize));
+        for (std::size_t i = nextBlock++; i < blockCount; i = nextBlock++) {
+            int blockIndex = static_cast<int>(i);
+            std::size_t length = storage.blockLength(blockIndex);
+            off_t offset = storage.blockOffset(blockIndex);
+            std::size_t done = 0;
+            while (done < length) {
+                ssize_t result = pread(storage.fd()->get(), buffer.data() + done, length - done,
+                                       offset + static_cast<off_t>(done));
+                if (result < 0 && errno == EINTR) {
+                    continue;
+                }
+                if (result <= 0) {
+                    break;
+                }
+                done += static_cast<std::size_t>(result);
+            }
+            valid[i] = done == length && FileProcessor::verifyBlock(info, blockIndex, buffer.data(), length);
+        }
+    };
+
+    unsigned threads = config.verifyThreads > 0 ? config.verifyThreads
+                                                : std::max(1u, std::thread::hardware_concurrency());
+    threads = static_cast<unsigned>(std::min<std::size_t>(threads, std::max<std::size_t>(blockCount, 1)));
+    std::vector<std::thread> workers;
+    for (unsigned i = 1; i < threads; ++i) {
+        workers.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : workers) {
+        thread.join();
+    }
+
+    return std::vector<bool>(valid.begin(), valid.end());
+}
+
+void Peer::openJournal(FileSession& session) {
+    // A metadata fica ao lado do diário para que a retomada não dependa dos vizinhos
+    auto targetDir = ensureDownloadDir(session);
+    const FileInfo& fileInfo = session.fileInfo;
+    try {
+        FileProcessor::writeMetadataFile(*session.remoteMetadata,
+                                         (targetDir / (fileInfo.fileName + ".meta")).string());
+        session.journal.open((targetDir / (fileInfo.fileName + ".journal")).string(), fileInfo,
+                             config.journalBatch, config.journalInterval);
+    } catch (const std::exception& e) {
+        Log::warn("[Cliente ", myPort, "] ", e.what(), "; download sem diário de retomada");
+        return;
+    }
+
+    // O .part já existia com o mesmo conteúdo: aproveita os blocos registrados
+    const auto& recovered = session.journal.recoveredBlocks();
+    std::size_t count = 0;
+    std::lock_guard<std::mutex> haveLock(session.haveMutex);
+    for (std::size_t i = 0; i < recovered.size(); ++i) {
+        if (recovered[i] && session.ownedBlocks.set(i)) {
+            announceBlockLocked(session, static_cast<int>(i));
+            ++count;
+        }
+    }
+    if (count > 0) {
+        Log::info("[Cliente ", myPort, "] ", count, " bloco(s) recuperado(s) do diário");
+    }
+}
+
+void Peer::flushJournal(FileSession& session) {
+    try {
+        session.journal.flush([&session] { session.fileStorage.sync(); });
+    } catch (const std::exception& e) {
+        Log::error("[Cliente ", myPort, "] ", e.what());
+    }
+}
+
+void Peer::openSeedSource(FileSession& session) {
+    // Serve direto do arquivo original quando a metadata aponta para ele;
+    // as cópias block_N.bin ficam como alternativa
+    const auto& localMetadata = session.localMetadata;
+    if (localMetadata->sourceFile.empty()) {
+        return;
+    }
+    try {
+        session.fileStorage.openExisting(localMetadata->sourceFile, session.fileInfo.fileSize,
+                                         session.fileInfo.blockSize);
+        Log::info("[Peer ", myPort, "] Servindo blocos de ", localMetadata->sourceFile);
+    } catch (const std::exception& e) {
+        if (localMetadata->blocksDirectory.empty()) {
+            throw;
+        }
+        Log::warn("[Peer ", myPort, "] ", e.what(), "; usando os arquivos de bloco em ",
+                  localMetadata->blocksDirectory);
+    }
 }
 
 void Peer::start() {
     // Cria e incia as threads de cliente e servidor
     std::thread serverThread(&Peer::serverLoop, this);
     std::thread clientThread(&Peer::clientLoop, this);
+    std::thread statsThread;
+    if (config.statsInterval.count() > 0) {
+        statsThread = std::thread(&Peer::statsLoop, this);
+    }
+    std::thread chokeThread;
+    if (uploads.enabled()) {
+        chokeThread = std::thread(&Peer::chokeLoop, this);
+    }
+    std::thread journalThread(&Peer::journalLoop, this);
 
     serverThread.join();
     clientThread.join();
+    journalThread.join();
+    if (statsThread.joinable()) {
+        statsThread.join();
+    }
+    if (chokeThread.joinable()) {
+        chokeThread.join();
+    }
 }
 
-void Peer::serverLoop() {
-    int sockfd = socket(AF_INET, SOCK_STREAM, 0);
-    if (sockfd < 0) {
-        throw std::runtime_error(std::string("ERRO ao criar socket servidor: ") + std::strerror(errno));
+void Peer::stop() {
+    {
+        std::lock_guard<std::mutex> lock(stopMutex);
+        running = false;
     }
-
-    sockaddr_in serv_addr{};
-    serv_addr.sin_family = AF_INET;
-    serv_addr.sin_addr.s_addr = INADDR_ANY;
-    serv_addr.sin_port = htons(myPort);
-
-    // Permite a reutilização do endereço para evitar erros de "Address already in use"
-    int opt = 1;
-    if (setsockopt(sockfd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt))) {
-        throw std::runtime_error(std::string("ERRO ao configurar SO_REUSEADDR: ") + std::strerror(errno));
+    stopCondition.notify_all();
+    {
+        // Sob journalMutex para a thread do diário não perder o aviso
+        std::lock_guard<std::mutex> lock(journalMutex);
+    }
+    journalWake.notify_all();
+    server.stop();
+    for (FileSession* session : sessions.all()) {
+        flushJournal(*session);
     }
 
-    if (bind(sockfd, (struct sockaddr *) &serv_addr, sizeof(serv_addr)) < 0) {
-        throw std::runtime_error(std::string("ERRO ao atrelar o endereço ao socket: ") + std::strerror(errno));
+    if (blockCache.enabled()) {
+        auto stats = blockCache.stats();
+        if (stats.hits + stats.misses > 0) {
+            Log::info("[Servidor ", myPort, "] Cache de blocos: ", stats.hits, " acertos, ", stats.misses,
+                      " falhas, ", stats.evictions, " descartes, ", stats.bytes, " de ", stats.capacityBytes,
+                      " bytes em uso");
+        }
     }
+}
 
-    listen(sockfd, 5);
-    std::cout << "[Servidor " << myPort << "] Aguardando conexões...\n";
+void Peer::waitFor(std::chrono::milliseconds duration) {
+    std::unique_lock<std::mutex> lock(stopMutex);
+    stopCondition.wait_for(lock, duration, [this] { return !running; });
+}
 
+void Peer::statsLoop() {
     while (running) {
-        sockaddr_in cli_addr{};
-        socklen_t clilen = sizeof(cli_addr);
-        int newsock = accept(sockfd, (struct sockaddr *) &cli_addr, &clilen);
+        waitFor(config.statsInterval);
+        if (!running) {
+            break;
+        }
+        std::string report = statsReport();
+        report.pop_back(); // o log acrescenta a quebra de linha
+        Log::info("[Peer ", myPort, "] Métricas:\n", report);
+    }
+}
 
-        if (newsock >= 0) {
-            std::thread(&Peer::handleConnection, this, newsock, cli_addr).detach();
+void Peer::journalLoop() {
+    std::unique_lock<std::mutex> lock(journalMutex);
+    while (running) {
+        journalWake.wait(lock, [this] { return journalFlushRequested || !running; });
+        journalFlushRequested = false;
+        lock.unlock();
+        // Os dois fdatasync de cada lote ficam aqui, fora das threads de rede e
+        // da thread de conclusão do disco; o encerramento grava o que sobrar
+        for (FileSession* session : sessions.all()) {
+            if (session->journalFlushDue.exchange(false)) {
+                flushJournal(*session);
+            }
         }
+        lock.lock();
     }
+}
 
-    close(sockfd);
+void Peer::chokeLoop() {
+    while (running) {
+        waitFor(config.chokeInterval);
+        if (!running) {
+            break;
+        }
+        // Reciprocidade: o que cada vizinho nos enviou; sem downloads em andamento,
+        // o escalonador usa o que cada conexão recebeu de nós
+        std::vector<std::uint64_t> fetchedFrom;
+        for (const auto& neighbor : metrics.snapshot().fetchedFrom) {
+            fetchedFrom.push_back(neighbor.bytes);
+        }
+        bool seeding = true;
+        for (const FileSession* session : sessions.all()) {
+            seeding = seeding && !session->downloading;
+        }
+        uploads.rechoke(fetchedFrom, seeding);
+    }
 }
 
-void Peer::handleConnection(int clientSock, sockaddr_in clientAddr) {
+std::string Peer::statsReport() const {
+    std::string report = Metrics::format(metrics.snapshot());
+    auto line = [&report](const std::string& key, std::uint64_t value) {
+        report += key + "=" + std::to_string(value) + "\n";
+    };
+    line("active_connections", server.connectionCount());
+    std::size_t owned = 0;
+    std::size_t total = 0;
+    std::uint64_t endgameRequests = 0;
+    auto published = sessions.all();
+    for (const FileSession* session : published) {
+        owned += session->ownedBlocks.count();
+        total += session->ownedBlocks.size();
+        endgameRequests += session->scheduler.endgameRequests();
+    }
+    line("files", published.size());
+    line("blocks_owned", owned);
+    line("blocks_total", total);
+    line("endgame_requests", endgameRequests);
+    for (const FileSession* session : published) {
+        line("file." + session->fileInfo.fileName + ".blocks_owned", session->ownedBlocks.count());
+    }
+    line("pending_writes", pendingWrites.load());
+    auto cache = blockCache.stats();
+    line("cache_hits", cache.hits);
+    line("cache_misses", cache.misses);
+    line("cache_evictions", cache.evictions);
+    line("cache_bytes", cache.bytes);
+    auto pool = framePool.stats();
+    line("frame_pool_buffers", pool.buffers);
+    line("frame_pool_in_use", pool.inUse);
+    line("frame_pool_bytes", pool.bytes);
+    line("frame_pool_unpooled", pool.unpooled);
+    auto disk = diskIo->stats();
+    report += std::string("disk_backend=") + diskIo->name() + "\n";
+    line("disk_operations", disk.operations);
+    line("disk_submit_calls", disk.submitCalls);
+    auto upload = uploads.stats();
+    line("upload_slots", config.uploadSlots);
+    line("upload_interested", upload.interested);
+    line("upload_unchoked", upload.unchoked);
+    line("upload_rounds", upload.rounds);
+    line("upload_chokes", upload.chokes);
+    line("upload_unchokes", upload.unchokes);
+    return report;
+}
 
-    // Captura a porta do cliente
-    char clientIP[INET_ADDRSTRLEN];
-    inet_ntop(AF_INET, &clientAddr.sin_addr, clientIP, sizeof(clientIP));
-    int clientPort = ntohs(clientAddr.sin_port);
+void Peer::handleStats(EventServer::Connection& connection) {
+    std::string report = statsReport();
+    std::vector<std::uint8_t> payload(report.begin(), report.end());
+    connection.send(Protocol::MessageType::STATS, payload);
+    metrics.add(Metrics::Counter::BytesOut, Protocol::HEADER_SIZE + payload.size());
+}
 
-    Protocol::MessageType type;
-    std::vector<std::uint8_t> payload;
-    if (!Protocol::receiveMessage(clientSock, type, payload)) {
-        std::cerr << "[Servidor " << myPort << "] Falha ao ler mensagem do cliente" << std::endl;
-        close(clientSock);
+void Peer::handleHandshake(const EventServer::ConnectionPtr& connection, const std::vector<std::uint8_t>& payload) {
+    if (payload.size() != sizeof(std::uint32_t)) {
+        sendErrorMessage(*connection, "Payload HANDSHAKE inválido");
         return;
     }
+    std::uint32_t portNetwork;
+    std::memcpy(&portNetwork, payload.data(), sizeof(portNetwork));
+    int listenPort = static_cast<int>(ntohl(portNetwork));
+
+    // O cliente conecta de uma porta efêmera; a porta de escuta diz qual vizinho ele é
+    int neighbor = -1;
+    for (std::size_t i = 0; i < neighbors.size(); ++i) {
+        if (neighbors[i].port == listenPort && neighbors[i].ip == connection->remoteIp()) {
+            neighbor = static_cast<int>(i);
+            break;
+        }
+    }
+    connection->setNeighbor(neighbor);
+    uploads.identify(connection, neighbor);
+}
 
+void Peer::serverLoop() {
+    Log::info("[Servidor ", myPort, "] Aguardando conexões com ", config.serverThreads,
+              " thread(s) de eventos...");
+    server.run();
+}
+
+void Peer::handleMessage(const EventServer::ConnectionPtr& connection, Protocol::MessageType type,
+                         const std::vector<std::uint8_t>& payload) {
+    metrics.add(Metrics::Counter::BytesIn, Protocol::HEADER_SIZE + payload.size());
     switch (type) {
         case Protocol::MessageType::GET_METADATA:
-            handleGetMetadata(clientSock);
+            handleGetMetadata(*connection, payload);
             break;
         case Protocol::MessageType::REQUEST_BLOCK:
-            handleRequestBlock(clientSock, payload, clientIP, clientPort);
+            handleRequestBlock(connection, payload);
+            break;
+        case Protocol::MessageType::BITFIELD:
+            handleBitfield(connection, payload);
+            break;
+        case Protocol::MessageType::STATS:
+            handleStats(*connection);
+            break;
+        case Protocol::MessageType::HANDSHAKE:
+            handleHandshake(connection, payload);
             break;
         default:
-            std::cout << "[Servidor " << myPort << "] Tipo de mensagem não suportado: "
-                      << static_cast<int>(type) << std::endl;
+            Log::warn("[Servidor ", myPort, "] Tipo de mensagem não suportado: ", static_cast<int>(type));
+            sendErrorMessage(*connection, "Tipo de mensagem não suportado");
             break;
     }
-
-    close(clientSock);
 }
 
 void Peer::clientLoop() {
-    sleep(2); // Espera os outros peers subirem
-
-    while (running) {
-
-        // Caso tenha terminado o download de todo os chuncks
-         if (!downloading) {
-            std::this_thread::sleep_for(std::chrono::seconds(5));
-            continue;  // Servidor permanece ativo
+    waitFor(config.startupDelay); // Espera os outros peers subirem
+
+    // Arquivos a baixar: os pedidos pelo checksum ou, sem pedidos, os downloads
+    // retomados; sem nenhum dos dois, o primeiro arquivo dos vizinhos ("" abaixo).
+    // Um seeder sem pedidos nem downloads retomados só precisa do servidor ativo.
+    std::vector<std::string> wanted;
+    // Um pedido inválido nunca é baixado: o download não pode ser dado como completo
+    bool allComplete = true;
+    for (const auto& checksum : config.wantedFiles) {
+        try {
+            wanted.push_back(FileSession::idFromChecksum(checksum));
+        } catch (const std::exception& e) {
+            Log::error("[Cliente ", myPort, "] ", e.what());
+            allComplete = false;
+        }
+    }
+    if (!config.wantedFiles.empty() && wanted.empty()) {
+        Log::error("[Cliente ", myPort, "] Nenhum checksum válido em --want: nada a baixar");
+        return;
+    }
+    if (config.wantedFiles.empty()) {
+        bool resumed = false;
+        for (FileSession* session : sessions.all()) {
+            // As sessões servidas já estão completas e são ignoradas por downloadSession
+            wanted.push_back(session->id);
+            resumed = resumed || session->downloading;
+        }
+        if (!metadataPaths.empty() && !resumed) {
+            return;
+        }
+        if (wanted.empty()) {
+            wanted.push_back("");
         }
+    }
 
-        for (const auto& neighbor : neighbors) {
-            int sockfd = socket(AF_INET, SOCK_STREAM, 0);
-            if (sockfd < 0) {
-                std::cerr << "ERRO ao criar socket cliente" << std::endl;
-                continue;
+    // Um arquivo de cada vez, cada um com um worker por vizinho
+    for (const auto& id : wanted) {
+        FileSession* session = id.empty() ? nullptr : sessions.find(id);
+        auto retryDelay = config.blockRetryInterval;
+        while (running && !session) {
+            for (const auto& neighbor : neighbors) {
+                session = fetchMetadata(neighbor, id);
+                if (session) {
+                    break;
+                }
             }
+            if (!session) {
+                // Espera antes de tentar se conectar a todos os vizinhos novamente
+                waitFor(retryDelay);
+                retryDelay = std::min(retryDelay * 2, config.retryInterval);
+            }
+        }
+        if (!running) {
+            return;
+        }
+        downloadSession(*session);
+        allComplete = allComplete && !session->downloading;
+    }
+    if (allComplete && running) {
+        downloading = false;
+    }
+}
 
-            sockaddr_in serv_addr{};
-            serv_addr.sin_family = AF_INET;
-            serv_addr.sin_port = htons(neighbor.port);
-            inet_pton(AF_INET, neighbor.ip.c_str(), &serv_addr.sin_addr);
+void Peer::downloadSession(FileSession& session) {
+    // Um arquivo servido ou retomado já completo não tem o que baixar
+    if (!session.downloading) {
+        return;
+    }
 
-            if (connect(sockfd, (struct sockaddr *) &serv_addr, sizeof(serv_addr)) < 0) {
-                std::cout << "[Cliente " << myPort << "] Falha na conexão com "
-                          << neighbor.ip << ":" << neighbor.port << std::endl;
-                close(sockfd);
-                continue;
+    const FileInfo& fileInfo = session.fileInfo;
+    if (!config.blockFiles && !session.fileStorage.isOpen()) {
+        // Arquivo provisório com o tamanho final; recebe o nome definitivo ao completar
+        auto targetDir = ensureDownloadDir(session);
+        auto partialPath = targetDir / (fileInfo.fileName + ".part");
+        try {
+            // Um diário sem o .part correspondente não vale mais nada
+            if (!std::filesystem::exists(partialPath)) {
+                std::filesystem::remove(targetDir / (fileInfo.fileName + ".journal"));
             }
+            session.fileStorage.open(partialPath.string(), fileInfo.fileSize, fileInfo.blockSize);
+            openJournal(session);
+        } catch (const std::exception& e) {
+            Log::warn("[Cliente ", myPort, "] ", e.what(), "; usando um arquivo por bloco");
+        }
+    }
+    if (session.hasAllBlocks()) {
+        tryAssembleFile(session);
+        return;
+    }
 
-            std::cout << "[Cliente " << myPort << "] Conectado com "
-                      << neighbor.ip << ":" << neighbor.port << std::endl;
+    std::size_t endgameBlocks = 0;
+    if (config.endgame) {
+        endgameBlocks = config.endgameBlocks > 0 ? config.endgameBlocks : config.pipelineWindow * neighbors.size();
+    }
+    session.scheduler.reset(session.ownedBlocks.toVector(), neighbors.size(), endgameBlocks);
 
-            if (!Protocol::sendMessage(sockfd, Protocol::MessageType::GET_METADATA, {})) {
-                std::cerr << "[Cliente " << myPort << "] Falha ao enviar GET_METADATA" << std::endl;
-                close(sockfd);
-                continue;
-            }
+    // Um worker por vizinho: blocos diferentes são baixados de todos ao mesmo tempo
+    std::vector<std::thread> workers;
+    for (std::size_t i = 0; i < neighbors.size(); ++i) {
+        workers.emplace_back(&Peer::neighborWorker, this, std::ref(session), i);
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
 
-            Protocol::MessageType responseType;
-            std::vector<std::uint8_t> payload;
-            if (!Protocol::receiveMessage(sockfd, responseType, payload)) {
-                std::cerr << "[Cliente " << myPort << "] Falha ao receber resposta" << std::endl;
-                close(sockfd);
-                continue;
-            }
+    // O último bloco foi registrado pela conclusão da gravação: a verificação do
+    // arquivo inteiro roda aqui, na thread do cliente
+    if (session.hasAllBlocks()) {
+        tryAssembleFile(session);
+    }
+}
 
-            if (responseType == Protocol::MessageType::METADATA_RESPONSE) {
-                std::string metadataText(payload.begin(), payload.end());
-                try {
-                    remoteMetadata = FileProcessor::parseMetadataString(metadataText);
-                    const auto& info = remoteMetadata->info;
-                    fileInfo = info;
-                    {
-                        std::lock_guard<std::mutex> lock(ownedBlocksMutex);
-                        if (ownedBlocks.empty() || ownedBlocks.size() != static_cast<std::size_t>(info.blockCount)) {
-                            ownedBlocks.assign(info.blockCount, localMetadata.has_value());
-                            if (!localMetadata) {
-                                std::fill(ownedBlocks.begin(), ownedBlocks.end(), false);
-                            }
-                        }
-                    }
-                    std::cout << "[Cliente " << myPort << "] Metadata recebida de "
-                              << neighbor.ip << ":" << neighbor.port << " -> arquivo "
-                              << info.fileName << ", blocos: " << info.blockCount
-                              << ", checksum: " << info.checksum << std::endl;
-                    if (!localMetadata) {
-                        int nextBlock = findNextMissingBlock();
-                        if (nextBlock >= 0) {
-                            requestBlockFromNeighbor(neighbor, nextBlock);
-                        }
-                    }
-                } catch (const std::exception& e) {
-                    std::cerr << "[Cliente " << myPort << "] Falha ao interpretar metadata: "
-                              << e.what() << std::endl;
-                }
-            } else if (responseType == Protocol::MessageType::ERROR) {
-                std::string errorMsg(payload.begin(), payload.end());
-                std::cerr << "[Cliente " << myPort << "] Erro remoto: " << errorMsg << std::endl;
-            } else {
-                std::cout << "[Cliente " << myPort << "] Tipo de resposta inesperado: "
-                          << static_cast<int>(responseType) << std::endl;
+FileSession* Peer::fetchMetadata(const NeighborInfo& neighbor, const std::string& id) {
+    Protocol::MessageType responseType;
+    std::vector<std::uint8_t> payload;
+    if (!exchangeMessage(neighbor, Protocol::MessageType::GET_METADATA,
+                         std::vector<std::uint8_t>(id.begin(), id.end()), responseType, payload)) {
+        Log::warn("[Cliente ", myPort, "] Falha na comunicação com ", neighbor.ip, ":", neighbor.port);
+        return nullptr;
+    }
+
+    if (responseType == Protocol::MessageType::METADATA_RESPONSE) {
+        try {
+            auto session = std::make_unique<FileSession>();
+            session->remoteMetadata = FileProcessor::parseMetadataBuffer(payload.data(), payload.size());
+            const auto& info = session->remoteMetadata->info;
+            session->fileInfo = info;
+            session->id = FileSession::idFromChecksum(info.checksum);
+            if (!id.empty() && session->id != id) {
+                throw std::runtime_error("o vizinho enviou a metadata de outro arquivo (" + info.checksum + ")");
             }
+            cacheMetadataPayload(*session, *session->remoteMetadata);
+            session->ownedBlocks.reset(static_cast<std::size_t>(info.blockCount), false);
+            session->metadataReady = true;
+            Log::info("[Cliente ", myPort, "] Metadata recebida de ", neighbor.ip, ":", neighbor.port,
+                      " -> arquivo ", info.fileName, ", blocos: ", info.blockCount, ", checksum: ",
+                      info.checksum);
+            // Publica a sessão para as threads do servidor
+            return &sessions.add(std::move(session));
+        } catch (const std::exception& e) {
+            Log::error("[Cliente ", myPort, "] Falha ao interpretar metadata: ", e.what());
+        }
+    } else if (responseType == Protocol::MessageType::ERROR) {
+        std::string errorMsg(payload.begin(), payload.end());
+        Log::warn("[Cliente ", myPort, "] Erro remoto: ", errorMsg);
+    } else {
+        Log::warn("[Cliente ", myPort, "] Tipo de resposta inesperado: ", static_cast<int>(responseType));
+    }
+    return nullptr;
+}
 
-            close(sockfd);
+void Peer::neighborWorker(FileSession& session, std::size_t worker) {
+    const NeighborInfo& neighbor = neighbors[worker];
+    DownloadScheduler& scheduler = session.scheduler;
+    while (running && session.downloading && !scheduler.isComplete()) {
+        downloadFromNeighbor(session, neighbor, worker);
+        if (scheduler.isComplete()) {
+            break;
         }
-        sleep(5); // Espera 5 segundos antes de tentar se conectar a todos os vizinhos novamente
+        // A conexão com o vizinho caiu: tenta reconectar após uma espera
+        waitFor(config.blockRetryInterval);
+        scheduler.clearFailures(worker);
     }
 }
 
-void Peer::handleGetMetadata(int clientSock) {
-    const FileProcessor::MetadataContent* metadataToSend = nullptr;
-    if (localMetadata) {
-        metadataToSend = &*localMetadata;
-    } else if (remoteMetadata) {
-        metadataToSend = &*remoteMetadata;
+FileSession* Peer::findSession(const std::vector<std::uint8_t>& payload, std::size_t bodySize) const {
+    if (payload.size() == bodySize) {
+        return sessions.first();
+    }
+    if (payload.size() != Protocol::FILE_ID_SIZE + bodySize) {
+        return nullptr;
     }
+    return sessions.find(std::string(payload.begin(), payload.begin() + Protocol::FILE_ID_SIZE));
+}
 
-    if (!metadataToSend) {
-        sendErrorMessage(clientSock, "Peer não possui metadata disponível");
+void Peer::handleGetMetadata(EventServer::Connection& connection, const std::vector<std::uint8_t>& payload) {
+    FileSession* session = findSession(payload, 0);
+    if (!session || !session->metadataReady) {
+        sendErrorMessage(connection, "Peer não possui metadata disponível");
         return;
     }
 
-    auto serialized = FileProcessor::serializeMetadata(*metadataToSend);
-    std::vector<std::uint8_t> payload(serialized.begin(), serialized.end());
-    if (!Protocol::sendMessage(clientSock, Protocol::MessageType::METADATA_RESPONSE, payload)) {
-        std::cerr << "[Servidor " << myPort << "] Falha ao enviar metadata" << std::endl;
-    } else {
-        std::cout << "[Servidor " << myPort << "] Metadata enviada para cliente" << std::endl;
-    }
+    connection.send(Protocol::MessageType::METADATA_RESPONSE, session->metadataPayload);
+    metrics.add(Metrics::Counter::BytesOut, Protocol::HEADER_SIZE + session->metadataPayload.size());
+    Log::info("[Servidor ", myPort, "] Metadata enviada para cliente");
+}
+
+void Peer::cacheMetadataPayload(FileSession& session, const FileProcessor::MetadataContent& metadata) {
+    // Serializada uma única vez, no formato binário. Os caminhos locais
+    // (blocks_dir, source_file) não interessam a quem recebe.
+    FileProcessor::MetadataContent shared = metadata;
+    shared.blocksDirectory.clear();
+    shared.sourceFile.clear();
+    auto serialized = FileProcessor::serializeMetadata(shared);
+    session.metadataPayload.assign(serialized.begin(), serialized.end());
 }
 
-void Peer::handleRequestBlock(int clientSock, const std::vector<std::uint8_t>& payload, const std::string& clientIP, int clientPort) {
-    if (payload.size() < sizeof(std::uint32_t)) {
-        sendErrorMessage(clientSock, "Payload REQUEST_BLOCK inválido");
+void Peer::handleRequestBlock(const EventServer::ConnectionPtr& connection, const std::vector<std::uint8_t>& payload) {
+    if (payload.size() != sizeof(std::uint32_t) &&
+        payload.size() != Protocol::FILE_ID_SIZE + sizeof(std::uint32_t)) {
+        sendErrorMessage(*connection, "Payload REQUEST_BLOCK inválido");
         return;
     }
 
+    // O índice fecha o payload, com ou sem o identificador do arquivo antes dele
     std::uint32_t blockIndexNetwork;
-    std::memcpy(&blockIndexNetwork, payload.data(), sizeof(blockIndexNetwork));
+    std::memcpy(&blockIndexNetwork, payload.data() + payload.size() - sizeof(blockIndexNetwork),
+                sizeof(blockIndexNetwork));
     int blockIndex = static_cast<int>(ntohl(blockIndexNetwork));
 
-    if (fileInfo.blockCount == 0) {
-        sendErrorMessage(clientSock, "Peer não possui informação de blocos disponível");
+    // Sem slot de upload a conexão já recebeu CHOKE; o pedido volta para o cliente
+    if (!uploads.admit(connection)) {
+        sendBlockError(*connection, blockIndex, "Conexão em choke");
+        return;
+    }
+
+    FileSession* found = findSession(payload, sizeof(std::uint32_t));
+    if (!found) {
+        sendBlockError(*connection, blockIndex, "Arquivo não disponível neste peer");
+        return;
+    }
+    FileSession& session = *found;
+    const FileInfo& fileInfo = session.fileInfo;
+    FileStorage& fileStorage = session.fileStorage;
+
+    if (!session.metadataReady || fileInfo.blockCount == 0) {
+        sendBlockError(*connection, blockIndex, "Peer não possui informação de blocos disponível");
         return;
     }
 
     if (blockIndex < 0 || blockIndex >= fileInfo.blockCount) {
-        sendErrorMessage(clientSock, "Índice de bloco inválido");
+        sendBlockError(*connection, blockIndex, "Índice de bloco inválido");
+        return;
+    }
+
+    if (!session.localMetadata && (!session.remoteMetadata || !session.hasBlock(blockIndex))) {
+        sendBlockError(*connection, blockIndex, "Bloco ainda não disponível");
         return;
     }
 
+    // Com o arquivo inteiro aberto, o page cache já guarda os blocos quentes e
+    // sendfile os envia sem cópia. Nos outros casos o bloco passa pela memória
+    // (ou exigiria abrir block_N.bin a cada pedido) e o cache evita relê-lo.
+    bool zeroCopy = config.zeroCopyServe && (fileStorage.isOpen() || !blockCache.enabled());
+    // Cache comum a todas as sessões: a chave junta o número da sessão e o índice
+    const std::uint64_t cacheKey = (static_cast<std::uint64_t>(session.number) << 32) |
+                                   static_cast<std::uint32_t>(blockIndex);
+    if (!zeroCopy && blockCache.enabled()) {
+        if (auto cached = blockCache.find(cacheKey)) {
+            sendBlockFrame(*connection, blockIndex, std::move(cached));
+            return;
+        }
+    }
+
+    // Origem do bloco: um arquivo block_N.bin inteiro ou um trecho do arquivo de destino
+    std::shared_ptr<FileDescriptor> blockFd;
+    off_t blockOffset = 0;
+    std::size_t blockLength = 0;
+
     namespace fs = std::filesystem;
     fs::path blockPath;
-    if (localMetadata) {
-        blockPath = fs::path(localMetadata->blocksDirectory) /
+    if (fileStorage.isOpen()) {
+        blockFd = fileStorage.fd();
+        blockOffset = fileStorage.blockOffset(blockIndex);
+        blockLength = fileStorage.blockLength(blockIndex);
+    } else if (session.localMetadata) {
+        blockPath = fs::path(session.localMetadata->blocksDirectory) /
                     ("block_" + std::to_string(blockIndex) + ".bin");
     } else {
-        if (!remoteMetadata || !hasBlock(blockIndex)) {
-            sendErrorMessage(clientSock, "Bloco ainda não disponível");
+        blockPath = ensureDownloadDir(session) /
+                    ("block_" + std::to_string(blockIndex) + ".bin");
+    }
+
+    if (!blockFd) {
+        blockFd = std::make_shared<FileDescriptor>(open(blockPath.c_str(), O_RDONLY | O_CLOEXEC));
+        struct stat blockStat{};
+        if (!blockFd->valid() || fstat(blockFd->get(), &blockStat) < 0) {
+            sendBlockError(*connection, blockIndex, "Bloco não encontrado");
             return;
         }
-        blockPath = ensureDownloadDir() /
-                    ("block_" + std::to_string(blockIndex) + ".bin");
+        blockLength = static_cast<std::size_t>(blockStat.st_size);
     }
 
-    std::ifstream blockFile(blockPath, std::ios::binary);
-    if (!blockFile) {
-        sendErrorMessage(clientSock, "Bloco não encontrado");
+    if (zeroCopy) {
+        // Só o cabeçalho e o índice passam pelo espaço de usuário; o conteúdo
+        // do bloco vai do page cache direto para o socket via sendfile
+        std::uint32_t indexNetwork = htonl(static_cast<std::uint32_t>(blockIndex));
+        connection->sendFile(Protocol::MessageType::BLOCK_DATA,
+                            reinterpret_cast<const std::uint8_t*>(&indexNetwork), sizeof(indexNetwork),
+                            std::move(blockFd), blockOffset, blockLength);
+        metrics.add(Metrics::Counter::BytesOut, Protocol::HEADER_SIZE + sizeof(indexNetwork) + blockLength);
+        metrics.recordServed(connection->neighbor(), blockLength);
+        uploads.recordUpload(*connection, blockLength);
+        Log::debug("[Servidor ", myPort, "] Cliente ", connection->remoteIp(), ":", connection->remotePort(),
+                   " Requisitou bloco ", blockIndex);
         return;
     }
 
-    std::vector<std::uint8_t> blockData((std::istreambuf_iterator<char>(blockFile)),
-                                        std::istreambuf_iterator<char>());
-
-    std::vector<std::uint8_t> response(sizeof(std::uint32_t) + blockData.size());
+    // O frame inteiro (cabeçalho, índice e bloco) é montado em um buffer do pool:
+    // o bloco é lido direto para a posição final e enfileirado sem cópia
+    constexpr std::size_t prefixSize = Protocol::HEADER_SIZE + sizeof(std::uint32_t);
+    PooledBuffer frame = framePool.acquire(
+        prefixSize + std::max(blockLength, static_cast<std::size_t>(fileInfo.blockSize)));
+    frame.resize(prefixSize + blockLength);
+    Protocol::encodeHeader(Protocol::MessageType::BLOCK_DATA,
+                           static_cast<std::uint32_t>(sizeof(std::uint32_t) + blockLength), frame.data());
     std::uint32_t indexNetwork = htonl(static_cast<std::uint32_t>(blockIndex));
-    std::memcpy(response.data(), &indexNetwork, sizeof(indexNetwork));
-    if (!blockData.empty()) {
-        std::memcpy(response.data() + sizeof(indexNetwork), blockData.data(), blockData.size());
+    std::memcpy(frame.data() + Protocol::HEADER_SIZE, &indexNetwork, sizeof(indexNetwork));
+
+    // A leitura vai para o backend de disco: a thread de rede segue atendendo as
+    // outras conexões e o frame é enviado quando a leitura termina
+    std::uint8_t* blockData = frame.data() + prefixSize;
+    auto readStart = std::chrono::steady_clock::now();
+    diskIo->read(blockFd->get(), blockData, blockLength, blockOffset,
+                 [this, connection, blockIndex, cacheKey, blockLength, frame, blockFd, readStart](ssize_t result) mutable {
+                     metrics.record(Metrics::Latency::DiskRead, std::chrono::steady_clock::now() - readStart);
+                     if (result != static_cast<ssize_t>(blockLength)) {
+                         sendBlockError(*connection, blockIndex, "Falha ao ler o bloco");
+                         return;
+                     }
+                     if (blockCache.enabled()) {
+                         blockCache.insert(cacheKey, frame);
+                     }
+                     sendBlockFrame(*connection, blockIndex, std::move(frame));
+                 });
+}
+
+void Peer::sendBlockFrame(EventServer::Connection& connection, int blockIndex, PooledBuffer frame) {
+    std::size_t frameSize = frame.size();
+    connection.sendFrame(std::move(frame));
+    metrics.add(Metrics::Counter::BytesOut, frameSize);
+    metrics.recordServed(connection.neighbor(), frameSize - Protocol::HEADER_SIZE - sizeof(std::uint32_t));
+    uploads.recordUpload(connection, frameSize - Protocol::HEADER_SIZE - sizeof(std::uint32_t));
+    Log::debug("[Servidor ", myPort, "] Cliente ", connection.remoteIp(), ":", connection.remotePort(),
+               " Requisitou bloco ", blockIndex);
+}
+
+void Peer::handleBitfield(const EventServer::ConnectionPtr& connection, const std::vector<std::uint8_t>& payload) {
+    FileSession* session = findSession(payload, 0);
+    if (!session || !session->metadataReady) {
+        sendErrorMessage(*connection, "Peer não possui metadata disponível");
+        return;
     }
 
-    if (!Protocol::sendMessage(clientSock, Protocol::MessageType::BLOCK_DATA, response)) {
-        std::cerr << "[Servidor " << myPort << "] Falha ao enviar bloco " << blockIndex << std::endl;
-    } else {
-        std::cout << "[Servidor " << myPort << "] Cliente " << clientIP << ":" << clientPort << " Requisitou bloco " << blockIndex << std::endl;
+    std::lock_guard<std::mutex> haveLock(session->haveMutex);
+    // Sob haveMutex nenhum bloco novo é marcado, então o mapa e os HAVE seguintes não se sobrepõem
+    auto bits = Protocol::encodeBitfield(session->ownedBlocks.snapshot(), session->ownedBlocks.size());
+    bool complete = session->ownedBlocks.all();
+    connection->send(Protocol::MessageType::BITFIELD, bits);
+    metrics.add(Metrics::Counter::BytesOut, Protocol::HEADER_SIZE + bits.size());
+
+    // Quem já tem todos os blocos nunca enviará HAVE
+    if (complete) {
+        return;
     }
+    for (const auto& subscriber : session->haveSubscribers) {
+        if (subscriber.lock() == connection) {
+            return;
+        }
+    }
+    session->haveSubscribers.push_back(connection);
 }
 
-void Peer::sendErrorMessage(int clientSock, const std::string& message) {
+void Peer::announceBlockLocked(FileSession& session, int blockIndex) {
+    std::uint32_t indexNetwork = htonl(static_cast<std::uint32_t>(blockIndex));
+    Protocol::PayloadPart part{&indexNetwork, sizeof(indexNetwork)};
+    auto it = session.haveSubscribers.begin();
+    while (it != session.haveSubscribers.end()) {
+        auto connection = it->lock();
+        if (!connection || connection->isClosed()) {
+            it = session.haveSubscribers.erase(it);
+            continue;
+        }
+        connection->send(Protocol::MessageType::HAVE, &part, 1);
+        metrics.add(Metrics::Counter::BytesOut, Protocol::HEADER_SIZE + sizeof(indexNetwork));
+        ++it;
+    }
+}
+
+void Peer::sendErrorMessage(EventServer::Connection& connection, const std::string& message) {
     std::vector<std::uint8_t> payload(message.begin(), message.end());
-    if (!Protocol::sendMessage(clientSock, Protocol::MessageType::ERROR, payload)) {
-        std::cerr << "[Servidor " << myPort << "] Falha ao enviar mensagem de erro" << std::endl;
+    connection.send(Protocol::MessageType::ERROR, payload);
+    metrics.add(Metrics::Counter::BytesOut, Protocol::HEADER_SIZE + payload.size());
+    metrics.add(Metrics::Counter::RequestErrors);
+}
+
+void Peer::sendBlockError(EventServer::Connection& connection, int blockIndex, const std::string& message) {
+    std::uint32_t indexNetwork = htonl(static_cast<std::uint32_t>(blockIndex));
+    Protocol::PayloadPart parts[] = {
+        {&indexNetwork, sizeof(indexNetwork)},
+        {message.data(), message.size()}
+    };
+    connection.send(Protocol::MessageType::BLOCK_ERROR, parts, 2);
+    metrics.add(Metrics::Counter::BytesOut, Protocol::HEADER_SIZE + sizeof(indexNetwork) + message.size());
+    metrics.add(Metrics::Counter::RequestErrors);
+}
+
+bool Peer::exchangeMessage(const NeighborInfo& neighbor, Protocol::MessageType type,
+                           const std::vector<std::uint8_t>& payload,
+                           Protocol::MessageType& responseType, std::vector<std::uint8_t>& responsePayload) {
+    // Uma conexão ociosa do pool pode ter sido encerrada pelo vizinho;
+    // nesse caso tenta novamente uma única vez com uma conexão nova.
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        int sockfd = attempt == 0 ? connectionPool.acquire(neighbor)
+                                  : ConnectionPool::connectTo(neighbor);
+        if (sockfd < 0) {
+            return false;
+        }
+
+        if (Protocol::sendMessage(sockfd, type, payload) &&
+            Protocol::receiveMessage(sockfd, responseType, responsePayload)) {
+            metrics.add(Metrics::Counter::BytesOut, Protocol::HEADER_SIZE + payload.size());
+            metrics.add(Metrics::Counter::BytesIn, Protocol::HEADER_SIZE + responsePayload.size());
+            connectionPool.release(neighbor, sockfd);
+            return true;
+        }
+        connectionPool.discard(sockfd);
     }
+    return false;
 }
 
-bool Peer::requestBlockFromNeighbor(const NeighborInfo& neighbor, int blockIndex) {
-    if (!remoteMetadata) {
+bool Peer::downloadFromNeighbor(FileSession& session, const NeighborInfo& neighbor, std::size_t worker) {
+    if (!session.remoteMetadata) {
         return false;
     }
+    DownloadScheduler& scheduler = session.scheduler;
+    // Os pedidos levam o identificador do arquivo; a conexão é exclusiva deste
+    // arquivo, então as respostas e os HAVE recebidos nela são dele
+    const Protocol::PayloadPart fileId{session.id.data(), session.id.size()};
 
-    int sockfd = socket(AF_INET, SOCK_STREAM, 0);
+    int sockfd = connectionPool.acquire(neighbor);
     if (sockfd < 0) {
-        std::cerr << "[Cliente " << myPort << "] ERRO ao criar socket para bloco" << std::endl;
+        Log::warn("[Cliente ", myPort, "] Falha ao conectar para solicitar blocos a ", neighbor.ip, ":",
+                  neighbor.port);
         return false;
     }
 
-    sockaddr_in serv_addr{};
-    serv_addr.sin_family = AF_INET;
-    serv_addr.sin_port = htons(neighbor.port);
-    inet_pton(AF_INET, neighbor.ip.c_str(), &serv_addr.sin_addr);
+    // Apresenta a porta de escuta, para o vizinho saber o quanto recebe de nós
+    // (reciprocidade dos slots de upload), e pede o mapa de blocos; a partir da
+    // resposta ele anuncia cada bloco novo nesta conexão com HAVE
+    std::uint32_t listenPortNetwork = htonl(static_cast<std::uint32_t>(myPort));
+    Protocol::PayloadPart handshake{&listenPortNetwork, sizeof(listenPortNetwork)};
+    bool healthy = Protocol::sendMessage(sockfd, Protocol::MessageType::HANDSHAKE, &handshake, 1) &&
+                   Protocol::sendMessage(sockfd, Protocol::MessageType::BITFIELD, &fileId, 1);
+    bool bitfieldPending = true;
+    bool subscribed = false;
+    // Em choke o vizinho recusa os pedidos: nenhum é enviado até o UNCHOKE
+    bool choked = false;
+
+    // Mantém até pipelineWindow pedidos pendentes na conexão. As respostas
+    // são associadas aos pedidos pelo índice do bloco carregado no payload.
+    std::vector<int> inFlight;
+    // Momento do envio de cada pedido de inFlight (mesma posição), para o RTT
+    std::vector<std::chrono::steady_clock::time_point> sentAt;
+    bool anySaved = false;
+    Protocol::MessageType responseType;
+    // Cada resposta chega em um buffer do pool; um bloco segue nele até o disco
+    PooledBuffer responsePayload;
+    const std::size_t payloadCapacity =
+        Protocol::HEADER_SIZE + sizeof(std::uint32_t) + static_cast<std::size_t>(session.fileInfo.blockSize);
+
+    while (running && healthy && !scheduler.isComplete()) {
+        while (!choked && inFlight.size() < config.pipelineWindow) {
+            int nextBlock = scheduler.acquireBlock(worker);
+            if (nextBlock < 0) {
+                break;
+            }
+            inFlight.push_back(nextBlock);
+            sentAt.push_back(std::chrono::steady_clock::now());
+            std::uint32_t indexNetwork = htonl(static_cast<std::uint32_t>(nextBlock));
+            Protocol::PayloadPart parts[] = {fileId, {&indexNetwork, sizeof(indexNetwork)}};
+            if (!Protocol::sendMessage(sockfd, Protocol::MessageType::REQUEST_BLOCK, parts, 2)) {
+                Log::error("[Cliente ", myPort, "] Falha ao enviar REQUEST_BLOCK");
+                healthy = false;
+                break;
+            }
+            metrics.add(Metrics::Counter::BytesOut, Protocol::HEADER_SIZE + fileId.size + sizeof(indexNetwork));
+        }
 
-    if (connect(sockfd, (struct sockaddr *) &serv_addr, sizeof(serv_addr)) < 0) {
-        std::cout << "[Cliente " << myPort << "] Falha ao conectar para solicitar bloco "
-                  << blockIndex << std::endl;
-        close(sockfd);
-        return false;
-    }
+        if (!healthy) {
+            break;
+        }
 
-    std::uint32_t indexNetwork = htonl(static_cast<std::uint32_t>(blockIndex));
-    std::vector<std::uint8_t> payload(sizeof(indexNetwork));
-    std::memcpy(payload.data(), &indexNetwork, sizeof(indexNetwork));
+        // Sem pedidos pendentes, aguarda anúncios HAVE. Com gravações ou pedidos
+        // pendentes a espera é curta: no endgame outro vizinho pode concluir os
+        // blocos pedidos aqui, e o download termina sem esperar estas respostas.
+        pollfd readable{sockfd, POLLIN, 0};
+        bool shortWait = !inFlight.empty() || pendingWrites > 0;
+        int timeout = shortWait ? 10 : static_cast<int>(config.blockRetryInterval.count());
+        int ready = poll(&readable, 1, timeout);
+        if (ready < 0 && errno != EINTR) {
+            healthy = false;
+            break;
+        }
+        if (ready <= 0) {
+            if (inFlight.empty()) {
+                scheduler.clearFailures(worker);
+                if (!subscribed && !bitfieldPending) {
+                    // O vizinho ainda não tinha metadata: pede o mapa de novo
+                    healthy = Protocol::sendMessage(sockfd, Protocol::MessageType::BITFIELD, &fileId, 1);
+                    bitfieldPending = true;
+                }
+            }
+            continue;
+        }
 
-    if (!Protocol::sendMessage(sockfd, Protocol::MessageType::REQUEST_BLOCK, payload)) {
-        std::cerr << "[Cliente " << myPort << "] Falha ao enviar REQUEST_BLOCK" << std::endl;
-        close(sockfd);
-        return false;
-    }
+        if (!Protocol::receiveMessage(sockfd, responseType, responsePayload, framePool, payloadCapacity)) {
+            Log::warn("[Cliente ", myPort, "] Falha ao receber bloco");
+            healthy = false;
+            break;
+        }
+        metrics.add(Metrics::Counter::BytesIn, Protocol::HEADER_SIZE + responsePayload.size());
 
-    Protocol::MessageType responseType;
-    std::vector<std::uint8_t> responsePayload;
-    if (!Protocol::receiveMessage(sockfd, responseType, responsePayload)) {
-        std::cerr << "[Cliente " << myPort << "] Falha ao receber bloco" << std::endl;
-        close(sockfd);
-        return false;
-    }
+        if (responseType == Protocol::MessageType::HAVE) {
+            if (responsePayload.size() >= sizeof(std::uint32_t)) {
+                std::uint32_t idxNetwork;
+                std::memcpy(&idxNetwork, responsePayload.data(), sizeof(idxNetwork));
+                scheduler.markAvailable(worker, static_cast<int>(ntohl(idxNetwork)));
+            }
+            continue;
+        }
+
+        if (responseType == Protocol::MessageType::CHOKE || responseType == Protocol::MessageType::UNCHOKE) {
+            choked = responseType == Protocol::MessageType::CHOKE;
+            Log::debug("[Cliente ", myPort, "] ", neighbor.ip, ":", neighbor.port, choked ? " CHOKE" : " UNCHOKE");
+            continue;
+        }
+
+        if (responseType == Protocol::MessageType::BITFIELD) {
+            scheduler.mergeBitfield(worker, responsePayload.data(), responsePayload.size());
+            bitfieldPending = false;
+            subscribed = true;
+            continue;
+        }
+
+        if (responseType == Protocol::MessageType::ERROR) {
+            std::string errorMsg(reinterpret_cast<const char*>(responsePayload.data()), responsePayload.size());
+            Log::warn("[Cliente ", myPort, "] Erro remoto: ", errorMsg);
+            bitfieldPending = false;
+            continue;
+        }
+
+        if (responseType != Protocol::MessageType::BLOCK_DATA &&
+            responseType != Protocol::MessageType::BLOCK_ERROR) {
+            Log::warn("[Cliente ", myPort, "] Resposta inesperada ao requisitar bloco: ",
+                      static_cast<int>(responseType));
+            healthy = false;
+            break;
+        }
 
-    bool success = false;
-    if (responseType == Protocol::MessageType::BLOCK_DATA) {
         if (responsePayload.size() < sizeof(std::uint32_t)) {
-            std::cerr << "[Cliente " << myPort << "] Payload BLOCK_DATA inválido" << std::endl;
-        } else {
-            std::uint32_t idxNetwork;
-            std::memcpy(&idxNetwork, responsePayload.data(), sizeof(idxNetwork));
-            int receivedIndex = static_cast<int>(ntohl(idxNetwork));
-            std::vector<std::uint8_t> blockBytes(responsePayload.begin() + sizeof(idxNetwork),
-                                                 responsePayload.end());
-            if (saveReceivedBlock(receivedIndex, blockBytes)) {
-                success = true;
-            }
+            Log::error("[Cliente ", myPort, "] Payload de resposta a bloco inválido");
+            healthy = false;
+            break;
+        }
+
+        std::uint32_t idxNetwork;
+        std::memcpy(&idxNetwork, responsePayload.data(), sizeof(idxNetwork));
+        int receivedIndex = static_cast<int>(ntohl(idxNetwork));
+        auto pending = std::find(inFlight.begin(), inFlight.end(), receivedIndex);
+        if (pending == inFlight.end()) {
+            Log::error("[Cliente ", myPort, "] Bloco ", receivedIndex, " recebido sem ter sido requisitado");
+            healthy = false;
+            break;
+        }
+        auto requestedAt = sentAt[static_cast<std::size_t>(pending - inFlight.begin())];
+        sentAt.erase(sentAt.begin() + (pending - inFlight.begin()));
+        inFlight.erase(pending);
+
+        if (responseType == Protocol::MessageType::BLOCK_ERROR && choked) {
+            // Recusado pelo choke, não pelo bloco: outro vizinho pode atendê-lo
+            scheduler.releaseBlocks({receivedIndex}, worker);
+            continue;
         }
-    } else if (responseType == Protocol::MessageType::ERROR) {
-        std::string errorMsg(responsePayload.begin(), responsePayload.end());
-        std::cerr << "[Cliente " << myPort << "] Erro ao requisitar bloco: " << errorMsg << std::endl;
-    } else {
-        std::cout << "[Cliente " << myPort << "] Resposta inesperada ao requisitar bloco: "
-                  << static_cast<int>(responseType) << std::endl;
-    }
 
-    close(sockfd);
+        if (responseType == Protocol::MessageType::BLOCK_ERROR) {
+            std::string errorMsg(reinterpret_cast<const char*>(responsePayload.data()) + sizeof(idxNetwork),
+                                 responsePayload.size() - sizeof(idxNetwork));
+            Log::warn("[Cliente ", myPort, "] Erro ao requisitar bloco ", receivedIndex, ": ", errorMsg);
+            metrics.recordFetchError(worker);
+            scheduler.failBlock(receivedIndex, worker);
+            continue;
+        }
 
-    if (success && !localMetadata) {
-        int nextBlock = findNextMissingBlock();
-        if (nextBlock >= 0) {
-            requestBlockFromNeighbor(neighbor, nextBlock);
-        } else if (hasAllBlocks()) {
-            tryAssembleFile();
+        if (!scheduler.deliverBlock(receivedIndex, worker)) {
+            // Outro vizinho entregou este bloco primeiro (endgame): a cópia é descartada
+            Log::debug("[Cliente ", myPort, "] Bloco ", receivedIndex, " duplicado descartado");
+            metrics.add(Metrics::Counter::DuplicateBlocks);
+            continue;
+        }
+        std::size_t blockBytes = responsePayload.size() - sizeof(idxNetwork);
+        if (saveReceivedBlock(session, receivedIndex, responsePayload, worker)) {
+            metrics.recordFetch(worker, blockBytes, std::chrono::steady_clock::now() - requestedAt);
+            anySaved = true;
+        } else {
+            metrics.recordFetchError(worker);
         }
     }
 
-    return success;
+    // Os blocos que ficaram sem resposta voltam para a fila e podem ir para outro
+    // vizinho. A conexão não volta ao pool: o vizinho continuaria enviando HAVE nela.
+    scheduler.releaseBlocks(inFlight, worker);
+    connectionPool.discard(sockfd);
+
+    return anySaved;
 }
 
-bool Peer::saveReceivedBlock(int blockIndex, const std::vector<std::uint8_t>& data) {
-    if (!remoteMetadata) {
+bool Peer::saveReceivedBlock(FileSession& session, int blockIndex, PooledBuffer payload, std::size_t worker) {
+    const std::uint8_t* data = payload.data() + sizeof(std::uint32_t);
+    std::size_t size = payload.size() - sizeof(std::uint32_t);
+    const auto& remoteMetadata = session.remoteMetadata;
+    DownloadScheduler& scheduler = session.scheduler;
+    FileStorage& fileStorage = session.fileStorage;
+    if (!remoteMetadata || blockIndex < 0 || blockIndex >= remoteMetadata->info.blockCount) {
+        scheduler.rejectBlock(blockIndex, worker);
+        return false;
+    }
+
+    // Verifica o bloco assim que chega: um bloco corrompido é descartado e
+    // pedido novamente sozinho, sem precisar baixar o arquivo inteiro de novo
+    if (!FileProcessor::verifyBlock(remoteMetadata->info, blockIndex, data, size)) {
+        Log::warn("[Cliente ", myPort, "] Bloco ", blockIndex,
+                  " com hash divergente, será requisitado novamente");
+        metrics.add(Metrics::Counter::HashFailures);
+        scheduler.rejectBlock(blockIndex, worker);
         return false;
     }
 
-    auto targetDir = ensureDownloadDir();
+    if (fileStorage.isOpen()) {
+        if (size != fileStorage.blockLength(blockIndex)) {
+            Log::error("[Cliente ", myPort, "] Bloco ", blockIndex, " com tamanho inválido");
+            scheduler.rejectBlock(blockIndex, worker);
+            return false;
+        }
+
+        // Grava na posição final do bloco dentro do arquivo pré-alocado, em segundo
+        // plano: o worker volta a ler a conexão enquanto o disco trabalha. O bloco
+        // continua reservado no scheduler até a gravação terminar.
+        waitForWriteSlot();
+        auto fd = fileStorage.fd();
+        auto writeStart = std::chrono::steady_clock::now();
+        diskIo->write(fd->get(), data, size, fileStorage.blockOffset(blockIndex),
+                      [this, &session, blockIndex, worker, size, payload, fd, writeStart](ssize_t result) {
+                          metrics.record(Metrics::Latency::DiskWrite, std::chrono::steady_clock::now() - writeStart);
+                          if (result != static_cast<ssize_t>(size)) {
+                              Log::error("[Cliente ", myPort, "] Falha ao gravar o bloco ", blockIndex, " em ",
+                                         session.fileStorage.path(), ": ",
+                                         result < 0 ? std::strerror(static_cast<int>(-result)) : "gravação incompleta");
+                              session.scheduler.rejectBlock(blockIndex, worker);
+                          } else {
+                              markBlockStored(session, blockIndex, session.fileStorage.path());
+                              session.scheduler.completeBlock(blockIndex);
+                          }
+                          finishWrite();
+                      });
+        return true;
+    }
 
-    std::filesystem::path blockPath = targetDir / ("block_" + std::to_string(blockIndex) + ".bin");
+    std::filesystem::path blockPath = ensureDownloadDir(session) / ("block_" + std::to_string(blockIndex) + ".bin");
+    auto writeStart = std::chrono::steady_clock::now();
     std::ofstream output(blockPath, std::ios::binary);
     if (!output) {
-        std::cerr << "[Cliente " << myPort << "] Não foi possível salvar bloco em "
-                  << blockPath << std::endl;
+        Log::error("[Cliente ", myPort, "] Não foi possível salvar bloco em ", blockPath);
+        scheduler.rejectBlock(blockIndex, worker);
         return false;
     }
-    if (!data.empty()) {
-        output.write(reinterpret_cast<const char*>(data.data()), data.size());
+    if (size > 0) {
+        output.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(size));
     }
     output.flush();
     output.close();
+    metrics.record(Metrics::Latency::DiskWrite, std::chrono::steady_clock::now() - writeStart);
 
+    markBlockStored(session, blockIndex, blockPath.string());
+    scheduler.completeBlock(blockIndex);
+    return true;
+}
+
+void Peer::markBlockStored(FileSession& session, int blockIndex, const std::string& location) {
     {
-        std::lock_guard<std::mutex> lock(ownedBlocksMutex);
-        if (static_cast<std::size_t>(blockIndex) >= ownedBlocks.size()) {
-            ownedBlocks.resize(blockIndex + 1, false);
+        // A marcação e o anúncio ficam sob haveMutex para que um vizinho que
+        // acabou de receber o BITFIELD não perca este bloco
+        std::lock_guard<std::mutex> haveLock(session.haveMutex);
+        if (!session.ownedBlocks.set(static_cast<std::size_t>(blockIndex))) {
+            return; // Outro worker já entregou este bloco
         }
-        ownedBlocks[blockIndex] = true;
+        announceBlockLocked(session, blockIndex);
     }
 
-    std::cout << "[Cliente " << myPort << "] Bloco " << blockIndex
-              << " salvo em " << blockPath << std::endl;
-
-    if (hasAllBlocks()) {
-        tryAssembleFile();
+    // O diário só registra o bloco. A gravação do lote (dois fdatasync) fica com
+    // a thread do diário e a montagem do arquivo com a thread do cliente, nunca
+    // com a thread de conclusão do backend de disco que chama esta função.
+    if (session.journal.isOpen() && session.journal.record(static_cast<std::size_t>(blockIndex))) {
+        session.journalFlushDue = true;
+        {
+            std::lock_guard<std::mutex> lock(journalMutex);
+            journalFlushRequested = true;
+        }
+        journalWake.notify_one();
     }
 
-    return true;
+    Log::debug("[Cliente ", myPort, "] Bloco ", blockIndex, " salvo em ", location);
 }
 
-int Peer::findNextMissingBlock() const {
-    std::lock_guard<std::mutex> lock(ownedBlocksMutex);
-    for (std::size_t i = 0; i < ownedBlocks.size(); ++i) {
-        if (!ownedBlocks[i]) {
-            return static_cast<int>(i);
-        }
+void Peer::waitForWriteSlot() {
+    // Limita os blocos em memória aguardando o disco
+    std::size_t limit = config.pipelineWindow * std::max<std::size_t>(neighbors.size(), 1);
+    std::unique_lock<std::mutex> lock(writeMutex);
+    writeDone.wait(lock, [this, limit] { return pendingWrites < limit || !running; });
+    ++pendingWrites;
+}
+
+void Peer::finishWrite() {
+    {
+        std::lock_guard<std::mutex> lock(writeMutex);
+        --pendingWrites;
     }
-    return -1;
+    writeDone.notify_all();
 }
 
-std::filesystem::path Peer::ensureDownloadDir() const {
+std::filesystem::path Peer::ensureDownloadDir(const FileSession& session) const {
     namespace fs = std::filesystem;
+    const auto& remoteMetadata = session.remoteMetadata;
     fs::path targetDir = fs::path(downloadRoot) / (remoteMetadata ? remoteMetadata->info.fileName : "unknown");
     fs::create_directories(targetDir);
     return targetDir;
 }
 
-bool Peer::hasBlock(int blockIndex) const {
-    std::lock_guard<std::mutex> lock(ownedBlocksMutex);
-    return blockIndex >= 0 && static_cast<std::size_t>(blockIndex) < ownedBlocks.size() && ownedBlocks[blockIndex];
-}
-
-bool Peer::hasAllBlocks() const {
-    std::lock_guard<std::mutex> lock(ownedBlocksMutex);
-    if (ownedBlocks.empty()) return false;
-    return std::all_of(ownedBlocks.begin(), ownedBlocks.end(), [](bool owned) { return owned; });
-}
-
-void Peer::tryAssembleFile() {
-    if (!remoteMetadata || fileAssembled) {
+void Peer::tryAssembleFile(FileSession& session) {
+    // Vários workers podem completar o último bloco ao mesmo tempo
+    std::lock_guard<std::mutex> lock(session.assembleMutex);
+    const auto& remoteMetadata = session.remoteMetadata;
+    FileStorage& fileStorage = session.fileStorage;
+    if (!remoteMetadata || session.fileAssembled) {
         return;
     }
-    if (findNextMissingBlock() >= 0) {
+    if (session.findNextMissingBlock() >= 0) {
         return;
     }
 
-    auto targetDir = ensureDownloadDir();
+    auto targetDir = ensureDownloadDir(session);
     namespace fs = std::filesystem;
+
+    if (fileStorage.isOpen()) {
+        // Os blocos já estão nas posições finais: basta conferir o arquivo
+        // e trocar o nome provisório pelo definitivo
+        try {
+            fileStorage.sync();
+            flushJournal(session);
+            auto checksum = FileProcessor::computeFileChecksum(fileStorage.path());
+            if (checksum == remoteMetadata->info.checksum) {
+                fileStorage.rename((targetDir / remoteMetadata->info.fileName).string());
+                session.downloading = false;
+                Log::info("[Cliente ", myPort, "] Download completo! Arquivo em ", fileStorage.path(),
+                          " (checksum OK)");
+            } else {
+                Log::error("[Cliente ", myPort, "] Checksum divergente: esperado ",
+                           remoteMetadata->info.checksum, ", obtido ", checksum);
+            }
+            session.fileAssembled = true;
+        } catch (const std::exception& e) {
+            Log::error("[Cliente ", myPort, "] Falha ao finalizar arquivo: ", e.what());
+        }
+        return;
+    }
+
     fs::path outputPath = targetDir / ("complete_" + remoteMetadata->info.fileName);
 
     std::ofstream output(outputPath, std::ios::binary | std::ios::trunc);
     if (!output) {
-        std::cerr << "[Cliente " << myPort << "] Não foi possível criar arquivo final em "
-                  << outputPath << std::endl;
+        Log::error("[Cliente ", myPort, "] Não foi possível criar arquivo final em ", outputPath);
         return;
     }
 
@@ -454,8 +1250,7 @@ void Peer::tryAssembleFile() {
         fs::path blockPath = targetDir / ("block_" + std::to_string(i) + ".bin");
         std::ifstream blockFile(blockPath, std::ios::binary);
         if (!blockFile) {
-            std::cerr << "[Cliente " << myPort << "] Bloco faltando durante montagem: "
-                      << blockPath << std::endl;
+            Log::error("[Cliente ", myPort, "] Bloco faltando durante montagem: ", blockPath);
             return;
         }
         std::vector<char> buffer((std::istreambuf_iterator<char>(blockFile)),
@@ -471,17 +1266,16 @@ void Peer::tryAssembleFile() {
     try {
         auto checksum = FileProcessor::computeFileChecksum(outputPath.string());
         if (checksum == remoteMetadata->info.checksum) {
-            // Finaliza a função de cliente
-            downloading = false;
-            std::cout << "[Cliente " << myPort << "] Download completo! Arquivo reconstituído em "
-                      << outputPath << " (checksum OK)" << std::endl;
+            // Finaliza o download deste arquivo
+            session.downloading = false;
+            Log::info("[Cliente ", myPort, "] Download completo! Arquivo reconstituído em ", outputPath,
+                      " (checksum OK)");
         } else {
-            std::cerr << "[Cliente " << myPort << "] Checksum divergente: esperado "
-                      << remoteMetadata->info.checksum << ", obtido " << checksum << std::endl;
+            Log::error("[Cliente ", myPort, "] Checksum divergente: esperado ", remoteMetadata->info.checksum,
+                       ", obtido ", checksum);
         }
-        fileAssembled = true;
+        session.fileAssembled = true;
     } catch (const std::exception& e) {
-        std::cerr << "[Cliente " << myPort << "] Falha ao calcular checksum: "
-                  << e.what() << std::endl;
+        Log::error("[Cliente ", myPort, "] Falha ao calcular checksum: ", e.what());
     }
 }
@@ -2,9 +2,12 @@
 #define PEER_H
 
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
 #include <filesystem>
+#include <memory>
 #include <mutex>
-#include <optional>
 #include <string>
 #include <thread>
 #include <utility>
@@ -12,51 +15,184 @@
 #include <netinet/in.h> 
 #include <arpa/inet.h>
 
+#include "BlockCache.h"
+#include "BufferPool.h"
+#include "ConnectionPool.h"
+#include "EventServer.h"
 #include "FileProcessor.h"
+#include "FileSession.h"
+#include "FileStorage.h"
+#include "Metrics.h"
+#include "NeighborInfo.h"
+#include "Protocol.h"
+#include "StorageBackend.h"
+#include "UploadScheduler.h"
 
-// Estrutura para armazenar informações do vizinho
-struct NeighborInfo {
-    std::string ip;
-    int port;
+// Parâmetros ajustáveis do peer
+struct PeerConfig {
+    // Quantidade máxima de REQUEST_BLOCK pendentes em uma mesma conexão
+    std::size_t pipelineWindow = 16;
+    // Modo endgame: com no máximo endgameBlocks blocos faltando, os que já estão
+    // em andamento são pedidos também aos outros vizinhos que os possuem.
+    // endgameBlocks = 0 usa pipelineWindow blocos por vizinho.
+    bool endgame = true;
+    std::size_t endgameBlocks = 0;
+    // Espera inicial para os outros peers subirem
+    std::chrono::milliseconds startupDelay { 2000 };
+    // Intervalo máximo entre as rodadas de contato com os vizinhos; a espera
+    // começa em blockRetryInterval e dobra a cada rodada sem resposta
+    std::chrono::milliseconds retryInterval { 5000 };
+    // Espera de um worker cujo vizinho não tem blocos disponíveis antes de tentar de novo
+    std::chrono::milliseconds blockRetryInterval { 500 };
+    // Threads reator do servidor orientado a eventos
+    std::size_t serverThreads = 2;
+    // Conexões que recebem blocos ao mesmo tempo (choke/unchoke), além do slot
+    // otimista; 0 atende todas. Os slots são reavaliados a cada chokeInterval e
+    // o slot otimista troca de dono a cada optimisticUnchokeRounds rodadas.
+    std::size_t uploadSlots = 4;
+    std::chrono::milliseconds chokeInterval { 5000 };
+    std::size_t optimisticUnchokeRounds = 3;
+    // Leituras e gravações de blocos fora das threads de rede
+    StorageBackend::Kind ioBackend = StorageBackend::Kind::Auto;
+    // Threads do backend de pool de threads; 0 usa o número de núcleos
+    unsigned ioThreads = 0;
+    // Envia blocos com sendfile; desligado, lê o bloco para a memória antes de enviar
+    bool zeroCopyServe = true;
+    // Orçamento do cache de blocos lidos para a memória (0 desliga). Usado quando o
+    // bloco não sai por sendfile do arquivo inteiro: cópia ou arquivos block_N.bin.
+    std::size_t blockCacheBytes = 64 * 1024 * 1024;
+    // Grava cada bloco em block_N.bin e monta complete_<arquivo> no final (modo antigo).
+    // Desligado, os blocos vão direto para a sua posição em um único arquivo pré-alocado.
+    bool blockFiles = false;
+    // Diário de blocos (downloads/<arquivo>/<arquivo>.journal): gravado a cada
+    // journalBatch blocos ou journalInterval, o que vier primeiro
+    std::size_t journalBatch = 64;
+    std::chrono::milliseconds journalInterval { 1000 };
+    // Ao retomar, confere o hash de todos os blocos do arquivo em vez de confiar no diário
+    bool verifyOnResume = false;
+    // Threads da reverificação; 0 usa o número de núcleos
+    unsigned verifyThreads = 0;
+    // Intervalo da impressão periódica das métricas (0 desliga); elas também
+    // podem ser consultadas a qualquer momento com uma mensagem STATS
+    std::chrono::milliseconds statsInterval { 0 };
+    // Arquivos a baixar, pelo checksum em hexadecimal. Vazio: o leecher baixa o
+    // primeiro arquivo dos vizinhos (ou retoma os downloads interrompidos)
+    std::vector<std::string> wantedFiles;
+    std::string downloadRoot = "downloads";
 };
 
 class Peer {
 public:
     // Construtor atualizado para aceitar uma lista de vizinhos e metadata opcional
-    Peer(int myPort, const std::vector<NeighborInfo>& neighbors, std::string metadataPath = "");
+    Peer(int myPort, const std::vector<NeighborInfo>& neighbors, std::string metadataPath = "",
+         PeerConfig config = PeerConfig());
+    // Seeder de vários arquivos: uma sessão por metadata, todas no mesmo servidor
+    Peer(int myPort, const std::vector<NeighborInfo>& neighbors, std::vector<std::string> metadataPaths,
+         PeerConfig config = PeerConfig());
     void start();
+    // Encerra servidor e cliente, fazendo start() retornar
+    void stop();
+    // Todos os arquivos pedidos foram baixados e conferidos
+    bool isDownloadComplete() const { return !downloading; }
+    BlockCache::Stats blockCacheStats() const { return blockCache.stats(); }
+    BufferPool::Stats framePoolStats() const { return framePool.stats(); }
+    Metrics::Snapshot metricsSnapshot() const { return metrics.snapshot(); }
+    // Métricas do peer, conexões e componentes, no formato da resposta STATS
+    std::string statsReport() const;
 
 private:
     int myPort;
+    PeerConfig config;
     std::vector<NeighborInfo> neighbors;
     std::atomic<bool> running;
     std::atomic<bool> downloading { true };
-    std::string metadataPath;
+    std::vector<std::string> metadataPaths;
     std::string downloadRoot;
-    bool fileAssembled = false;
 
-    // Gerenciamento de arquivos e blocos
-    FileInfo fileInfo;
-    std::vector<bool> ownedBlocks;
+    // Um arquivo por sessão; declarado antes de quem guarda referências a elas
+    SessionRegistry sessions;
+    // Frames BLOCK_DATA do caminho de cópia; declarado antes de quem guarda os
+    // buffers (cache e servidor) para ser destruído depois deles
+    BufferPool framePool;
+    // Blocos mais pedidos já em memória, compartilhados pelas threads do servidor
+    BlockCache blockCache;
 
-    std::optional<FileProcessor::MetadataContent> localMetadata;
-    std::optional<FileProcessor::MetadataContent> remoteMetadata;
-    mutable std::mutex ownedBlocksMutex;
+    // Conexões persistentes com os vizinhos, reutilizadas entre mensagens
+    ConnectionPool connectionPool;
 
+    // Controle de encerramento
+    std::mutex stopMutex;
+    std::condition_variable stopCondition;
+
+    // Contadores e latências, atualizados sem lock pelas threads do servidor,
+    // pelos workers e pelas conclusões de disco
+    Metrics metrics;
+
+    // Quais conexões recebem blocos (choke/unchoke)
+    UploadScheduler uploads;
+
+    EventServer server;
+
+    // Lotes do diário a gravar, avisados pela conclusão das gravações de blocos
+    std::mutex journalMutex;
+    std::condition_variable journalWake;
+    bool journalFlushRequested = false;
+
+    // Gravações de blocos submetidas e ainda não concluídas
+    std::mutex writeMutex;
+    std::condition_variable writeDone;
+    std::atomic<std::size_t> pendingWrites { 0 };
+
+    // Declarado por último para ser destruído primeiro: espera as operações
+    // pendentes, cujas conclusões usam os demais membros
+    std::unique_ptr<StorageBackend> diskIo;
+
+    void loadSeedSession(const std::string& metadataPath);
+    void openSeedSource(FileSession& session);
+    void resumeDownloads();
+    bool resumeDownload(const std::filesystem::path& targetDir);
+    std::vector<bool> verifyStoredBlocks(const FileStorage& storage, const FileInfo& info) const;
+    void openJournal(FileSession& session);
+    void flushJournal(FileSession& session);
     void serverLoop();
     void clientLoop();
-    void handleConnection(int clientSock, sockaddr_in clientAddr);
-    void handleGetMetadata(int clientSock);
-    void handleRequestBlock(int clientSock, const std::vector<std::uint8_t>& payload, const std::string& clientIP, int clientPort);
-    void sendErrorMessage(int clientSock, const std::string& message);
-
-    bool requestBlockFromNeighbor(const NeighborInfo& neighbor, int blockIndex);
-    bool saveReceivedBlock(int blockIndex, const std::vector<std::uint8_t>& data);
-    int findNextMissingBlock() const;
-    void tryAssembleFile();
-    std::filesystem::path ensureDownloadDir() const;
-    bool hasBlock(int blockIndex) const;
-    bool hasAllBlocks() const;
+    void handleMessage(const EventServer::ConnectionPtr& connection, Protocol::MessageType type,
+                       const std::vector<std::uint8_t>& payload);
+    // Sessão de um pedido: pelo identificador no início do payload ou, sem ele, a primeira
+    FileSession* findSession(const std::vector<std::uint8_t>& payload, std::size_t bodySize) const;
+    void handleGetMetadata(EventServer::Connection& connection, const std::vector<std::uint8_t>& payload);
+    void handleStats(EventServer::Connection& connection);
+    void statsLoop();
+    void handleHandshake(const EventServer::ConnectionPtr& connection, const std::vector<std::uint8_t>& payload);
+    // Reavalia periodicamente os slots de upload
+    void chokeLoop();
+    // Grava os lotes do diário das sessões marcadas com journalFlushDue
+    void journalLoop();
+    static void cacheMetadataPayload(FileSession& session, const FileProcessor::MetadataContent& metadata);
+    void handleBitfield(const EventServer::ConnectionPtr& connection, const std::vector<std::uint8_t>& payload);
+    void announceBlockLocked(FileSession& session, int blockIndex);
+    void handleRequestBlock(const EventServer::ConnectionPtr& connection, const std::vector<std::uint8_t>& payload);
+    void sendErrorMessage(EventServer::Connection& connection, const std::string& message);
+    void sendBlockFrame(EventServer::Connection& connection, int blockIndex, PooledBuffer frame);
+    void sendBlockError(EventServer::Connection& connection, int blockIndex, const std::string& message);
+
+    bool exchangeMessage(const NeighborInfo& neighbor, Protocol::MessageType type,
+                         const std::vector<std::uint8_t>& payload,
+                         Protocol::MessageType& responseType, std::vector<std::uint8_t>& responsePayload);
+    // Pede a metadata do arquivo `id` (vazio: o primeiro do vizinho) e publica a sessão
+    FileSession* fetchMetadata(const NeighborInfo& neighbor, const std::string& id);
+    void downloadSession(FileSession& session);
+    void neighborWorker(FileSession& session, std::size_t worker);
+    bool downloadFromNeighbor(FileSession& session, const NeighborInfo& neighbor, std::size_t worker);
+    // Verifica e grava um bloco recebido (payload: índice + dados). Retorna false se
+    // o bloco foi recusado; o scheduler é avisado quando a gravação termina.
+    bool saveReceivedBlock(FileSession& session, int blockIndex, PooledBuffer payload, std::size_t worker);
+    void markBlockStored(FileSession& session, int blockIndex, const std::string& location);
+    void waitForWriteSlot();
+    void finishWrite();
+    void waitFor(std::chrono::milliseconds duration);
+    void tryAssembleFile(FileSession& session);
+    std::filesystem::path ensureDownloadDir(const FileSession& session) const;
 };
 
 #endif
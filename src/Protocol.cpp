@@ -1,23 +1,46 @@
 #include "Protocol.h"
 
 #include <arpa/inet.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
 #include <cstring>
 
 namespace {
 
-constexpr std::size_t HEADER_SIZE = 5; // 1 byte type + 4 bytes payload size
+constexpr std::size_t MAX_PARTS = 8;
 
-bool writeAll(int fd, const void* buffer, std::size_t bytes) {
-    const std::uint8_t* data = static_cast<const std::uint8_t*>(buffer);
-    std::size_t total = 0;
-    while (total < bytes) {
-        ssize_t written = ::write(fd, data + total, bytes - total);
+std::atomic<std::uint32_t> frameLimit { Protocol::DEFAULT_MAX_FRAME_SIZE };
+
+// sendmsg em vez de writev para passar MSG_NOSIGNAL: um vizinho que fecha a
+// conexão vira um erro de envio (EPIPE), não um SIGPIPE
+bool writevAll(int fd, iovec* iov, int count) {
+    while (count > 0) {
+        msghdr message{};
+        message.msg_iov = iov;
+        message.msg_iovlen = static_cast<std::size_t>(count);
+        ssize_t written = ::sendmsg(fd, &message, MSG_NOSIGNAL);
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
         if (written <= 0) {
             return false;
         }
-        total += static_cast<std::size_t>(written);
+        // Avança sobre os trechos já escritos após uma escrita parcial
+        std::size_t remaining = static_cast<std::size_t>(written);
+        while (count > 0 && remaining >= iov->iov_len) {
+            remaining -= iov->iov_len;
+            ++iov;
+            --count;
+        }
+        if (count > 0) {
+            iov->iov_base = static_cast<std::uint8_t*>(iov->iov_base) + remaining;
+            iov->iov_len -= remaining;
+        }
     }
     return true;
 }
@@ -27,6 +50,9 @@ bool readAll(int fd, void* buffer, std::size_t bytes) {
     std::size_t total = 0;
     while (total < bytes) {
         ssize_t readBytes = ::read(fd, data + total, bytes - total);
+        if (readBytes < 0 && errno == EINTR) {
+            continue;
+        }
         if (readBytes <= 0) {
             return false;
         }
@@ -35,48 +61,135 @@ bool readAll(int fd, void* buffer, std::size_t bytes) {
     return true;
 }
 
+bool receiveHeader(int fd, Protocol::MessageType& type, std::uint32_t& payloadSize) {
+    std::uint8_t header[Protocol::HEADER_SIZE];
+    if (!readAll(fd, header, Protocol::HEADER_SIZE)) {
+        return false;
+    }
+    payloadSize = Protocol::decodeHeader(header, type);
+    return payloadSize <= Protocol::maxFrameSize();
+}
+
 } // namespace
 
 namespace Protocol {
 
-bool sendMessage(int sockfd, MessageType type, const std::vector<std::uint8_t>& payload) {
-    std::uint8_t header[HEADER_SIZE];
+void setMaxFrameSize(std::uint32_t bytes) {
+    frameLimit = bytes;
+}
+
+std::uint32_t maxFrameSize() {
+    return frameLimit.load(std::memory_order_relaxed);
+}
+
+void ReceiveBuffer::resize(std::size_t newSize) {
+    if (newSize > allocated) {
+        storage.reset(new std::uint8_t[newSize]);
+        allocated = newSize;
+    }
+    length = newSize;
+}
+
+void encodeHeader(MessageType type, std::uint32_t payloadSize, std::uint8_t* header) {
     header[0] = static_cast<std::uint8_t>(type);
-    std::uint32_t payloadSize = htonl(static_cast<std::uint32_t>(payload.size()));
-    std::memcpy(header + 1, &payloadSize, sizeof(payloadSize));
+    std::uint32_t payloadSizeNetwork = htonl(payloadSize);
+    std::memcpy(header + 1, &payloadSizeNetwork, sizeof(payloadSizeNetwork));
+}
+
+std::uint32_t decodeHeader(const std::uint8_t* header, MessageType& type) {
+    type = static_cast<MessageType>(header[0]);
+    std::uint32_t payloadSizeNetwork;
+    std::memcpy(&payloadSizeNetwork, header + 1, sizeof(payloadSizeNetwork));
+    return ntohl(payloadSizeNetwork);
+}
+
+std::vector<std::uint8_t> encodeBitfield(const std::vector<std::uint64_t>& words, std::size_t blockCount) {
+    std::vector<std::uint8_t> bits((blockCount + 7) / 8, 0);
+    for (std::size_t byte = 0; byte < bits.size(); ++byte) {
+        // Oito blocos por byte; na palavra o bloco menor fica no bit menos significativo
+        std::uint8_t source = static_cast<std::uint8_t>(words[byte / 8] >> ((byte % 8) * 8));
+        std::uint8_t reversed = 0;
+        for (int bit = 0; bit < 8; ++bit) {
+            if (source & (1u << bit)) {
+                reversed |= static_cast<std::uint8_t>(0x80u >> bit);
+            }
+        }
+        bits[byte] = reversed;
+    }
+    return bits;
+}
+
+bool bitfieldHas(const std::uint8_t* bits, std::size_t size, std::size_t blockIndex) {
+    return blockIndex / 8 < size && (bits[blockIndex / 8] & (0x80u >> (blockIndex % 8))) != 0;
+}
 
-    if (!writeAll(sockfd, header, HEADER_SIZE)) {
+bool sendMessage(int sockfd, MessageType type, const PayloadPart* parts, std::size_t partCount) {
+    if (partCount > MAX_PARTS) {
         return false;
     }
 
-    if (!payload.empty()) {
-        if (!writeAll(sockfd, payload.data(), payload.size())) {
-            return false;
+    std::size_t payloadSize = 0;
+    iovec iov[MAX_PARTS + 1];
+    int iovCount = 1;
+    for (std::size_t i = 0; i < partCount; ++i) {
+        if (parts[i].size == 0) {
+            continue;
         }
+        iov[iovCount].iov_base = const_cast<void*>(parts[i].data);
+        iov[iovCount].iov_len = parts[i].size;
+        payloadSize += parts[i].size;
+        ++iovCount;
     }
 
-    return true;
+    std::uint8_t header[HEADER_SIZE];
+    encodeHeader(type, static_cast<std::uint32_t>(payloadSize), header);
+    iov[0].iov_base = header;
+    iov[0].iov_len = HEADER_SIZE;
+
+    return writevAll(sockfd, iov, iovCount);
 }
 
-bool receiveMessage(int sockfd, MessageType& type, std::vector<std::uint8_t>& payload) {
-    std::uint8_t header[HEADER_SIZE];
-    if (!readAll(sockfd, header, HEADER_SIZE)) {
+bool sendMessage(int sockfd, MessageType type, const std::vector<std::uint8_t>& payload) {
+    PayloadPart part{payload.data(), payload.size()};
+    return sendMessage(sockfd, type, &part, 1);
+}
+
+bool receiveMessage(int sockfd, MessageType& type, ReceiveBuffer& payload) {
+    std::uint32_t payloadSize;
+    if (!receiveHeader(sockfd, type, payloadSize)) {
         return false;
     }
 
-    type = static_cast<MessageType>(header[0]);
-    std::uint32_t payloadSizeNetwork;
-    std::memcpy(&payloadSizeNetwork, header + 1, sizeof(payloadSizeNetwork));
-    std::uint32_t payloadSize = ntohl(payloadSizeNetwork);
+    payload.resize(payloadSize);
+    return payloadSize == 0 || readAll(sockfd, payload.data(), payloadSize);
+}
+
+bool receiveMessage(int sockfd, MessageType& type, std::vector<std::uint8_t>& payload) {
+    std::uint32_t payloadSize;
+    if (!receiveHeader(sockfd, type, payloadSize)) {
+        return false;
+    }
 
     payload.resize(payloadSize);
-    if (payloadSize > 0) {
-        if (!readAll(sockfd, payload.data(), payloadSize)) {
-            return false;
-        }
+    return payloadSize == 0 || readAll(sockfd, payload.data(), payloadSize);
+}
+
+bool receiveMessage(int sockfd, MessageType& type, PooledBuffer& payload, BufferPool& pool,
+                    std::size_t minCapacity) {
+    std::uint32_t payloadSize;
+    if (!receiveHeader(sockfd, type, payloadSize)) {
+        return false;
     }
 
-    return true;
+    // Só a capacidade fixa de frame de bloco vem do pool; payloads maiores (metadata,
+    // bitfield) usam um buffer avulso em vez de criar uma classe por tamanho
+    if (payloadSize <= minCapacity) {
+        payload = pool.acquire(minCapacity);
+    } else {
+        payload = pool.allocate(payloadSize);
+    }
+    payload.resize(payloadSize);
+    return payloadSize == 0 || readAll(sockfd, payload.data(), payloadSize);
 }
 
 } // namespace Protocol
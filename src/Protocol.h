@@ -1,21 +1,98 @@
 #ifndef PROTOCOL_H
 #define PROTOCOL_H
 
+#include <cstddef>
 #include <cstdint>
+#include <memory>
 #include <vector>
 
+#include "BufferPool.h"
+
 namespace Protocol {
 
+// Um peer pode servir vários arquivos. GET_METADATA, REQUEST_BLOCK e o pedido de
+// BITFIELD começam com o identificador do arquivo (FILE_ID_SIZE bytes, o checksum
+// SHA-256 do conteúdo); sem ele, o pedido vale para o primeiro arquivo do peer.
+// As respostas não repetem o identificador: o cliente usa uma conexão por arquivo.
 enum class MessageType : std::uint8_t {
+    // Pedido: vazio ou identificador do arquivo
     GET_METADATA = 1,
     METADATA_RESPONSE = 2,
+    // Pedido: [identificador] + índice do bloco (4 bytes)
     REQUEST_BLOCK = 3,
     BLOCK_DATA = 4,
-    ERROR = 5
+    ERROR = 5,
+    // Falha ao atender um REQUEST_BLOCK: índice (4 bytes) + mensagem de erro.
+    // Carrega o índice para que o cliente com pedidos em pipeline saiba qual falhou.
+    BLOCK_ERROR = 6,
+    // Pedido (vazio ou identificador) ou resposta com o mapa de blocos que o peer possui,
+    // um bit por bloco, bit mais significativo primeiro. Quem pede passa a receber HAVE.
+    BITFIELD = 7,
+    // Anúncio de um bloco recém-obtido pelo peer: índice (4 bytes)
+    HAVE = 8,
+    // Pedido (payload vazio) ou resposta com as métricas do peer em texto,
+    // uma linha "chave=valor" por métrica
+    STATS = 9,
+    // Servidor -> cliente, payload vazio: a partir daqui os REQUEST_BLOCK desta
+    // conexão são recusados com BLOCK_ERROR até um UNCHOKE. Uma conexão começa liberada.
+    CHOKE = 10,
+    UNCHOKE = 11,
+    // Cliente -> servidor, sem resposta: porta em que o cliente escuta (4 bytes).
+    // Identifica a conexão como um vizinho para a reciprocidade do upload.
+    HANDSHAKE = 12
+};
+
+constexpr std::size_t HEADER_SIZE = 5; // 1 byte type + 4 bytes payload size
+constexpr std::size_t FILE_ID_SIZE = 32;
+constexpr std::uint32_t DEFAULT_MAX_FRAME_SIZE = 64u * 1024u * 1024u;
+
+// Maior payload aceito ao receber; mensagens maiores são tratadas como erro de protocolo
+void setMaxFrameSize(std::uint32_t bytes);
+std::uint32_t maxFrameSize();
+
+// Trecho de memória que compõe o payload de uma mensagem
+struct PayloadPart {
+    const void* data;
+    std::size_t size;
+};
+
+// Buffer de recepção reaproveitável: só realoca quando um payload maior chega
+// e não inicializa os bytes que serão sobrescritos pela leitura.
+class ReceiveBuffer {
+public:
+    const std::uint8_t* data() const { return storage.get(); }
+    std::uint8_t* data() { return storage.get(); }
+    std::size_t size() const { return length; }
+    std::size_t capacity() const { return allocated; }
+
+    void resize(std::size_t newSize);
+
+private:
+    std::unique_ptr<std::uint8_t[]> storage;
+    std::size_t allocated = 0;
+    std::size_t length = 0;
 };
 
+// Codifica/decodifica o cabeçalho, para quem monta as mensagens fora de sendMessage
+void encodeHeader(MessageType type, std::uint32_t payloadSize, std::uint8_t* header);
+std::uint32_t decodeHeader(const std::uint8_t* header, MessageType& type);
+
+// Mapa de blocos no formato de BITFIELD: um bit por bloco, o bloco 0 no bit
+// mais significativo do primeiro byte. words segue AtomicBitmap::snapshot.
+std::vector<std::uint8_t> encodeBitfield(const std::vector<std::uint64_t>& words, std::size_t blockCount);
+bool bitfieldHas(const std::uint8_t* bits, std::size_t size, std::size_t blockIndex);
+
+// Envia cabeçalho e payload com um único writev (repetido só em escritas parciais)
+bool sendMessage(int sockfd, MessageType type, const PayloadPart* parts, std::size_t partCount);
 bool sendMessage(int sockfd, MessageType type, const std::vector<std::uint8_t>& payload);
+
+bool receiveMessage(int sockfd, MessageType& type, ReceiveBuffer& payload);
 bool receiveMessage(int sockfd, MessageType& type, std::vector<std::uint8_t>& payload);
+// Recebe o payload em um buffer do pool, que pode seguir adiante (ex.: gravação
+// assíncrona) sem cópia. Payloads de até minCapacity bytes usam a classe de
+// capacidade minCapacity; maiores vêm do heap, sem criar classes novas no pool.
+bool receiveMessage(int sockfd, MessageType& type, PooledBuffer& payload, BufferPool& pool,
+                    std::size_t minCapacity);
 
 } // namespace Protocol
 
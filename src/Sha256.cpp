@@ -0,0 +1,315 @@
+#include "Sha256.h"
+#include "Sha256Backends.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <mutex>
+
+namespace {
+
+using Sha256Backends::CompressFn;
+
+std::atomic<Sha256::Backend> activeBackend{Sha256::Backend::Scalar};
+std::atomic<CompressFn> activeCompress{Sha256Backends::compressScalar};
+std::once_flag selectionFlag;
+bool shaNiVerified = false;
+bool avx2Verified = false;
+
+CompressFn compressFor(Sha256::Backend backend) {
+    // O multi-buffer só vale para hashMany; um único fluxo usa o escalar
+    return backend == Sha256::Backend::ShaNi ? Sha256Backends::compressShaNi
+                                             : Sha256Backends::compressScalar;
+}
+
+Sha256::Digest digestFromState(const std::uint32_t* state) {
+    Sha256::Digest digest{};
+    for (int i = 0; i < 8; ++i) {
+        digest[i * 4 + 0] = static_cast<unsigned char>((state[i] >> 24) & 0xFF);
+        digest[i * 4 + 1] = static_cast<unsigned char>((state[i] >> 16) & 0xFF);
+        digest[i * 4 + 2] = static_cast<unsigned char>((state[i] >> 8) & 0xFF);
+        digest[i * 4 + 3] = static_cast<unsigned char>(state[i] & 0xFF);
+    }
+    return digest;
+}
+
+// Copia o resto da mensagem (< 64 bytes) para `tail` e aplica o padding.
+// Retorna quantos blocos de 64 bytes o final ocupa (1 ou 2).
+std::size_t padTail(const unsigned char* rest, std::size_t restLen, std::uint64_t totalBits,
+                    unsigned char* tail) {
+    std::size_t tailBlocks = restLen < 56 ? 1 : 2;
+    std::size_t tailLen = tailBlocks * 64;
+    if (restLen > 0) {
+        std::memcpy(tail, rest, restLen);
+    }
+    tail[restLen] = 0x80;
+    std::memset(tail + restLen + 1, 0, tailLen - restLen - 1 - 8);
+    for (int i = 7; i >= 0; --i) {
+        tail[tailLen - 1 - i] = static_cast<unsigned char>((totalBits >> (i * 8)) & 0xFF);
+    }
+    return tailBlocks;
+}
+
+Sha256::Digest hashOneWith(CompressFn compress, const void* data, std::size_t len) {
+    const auto* bytes = static_cast<const unsigned char*>(data);
+    std::uint32_t state[8];
+    std::memcpy(state, Sha256Backends::initialState, sizeof(state));
+
+    std::size_t fullBlocks = len / 64;
+    if (fullBlocks > 0) {
+        compress(state, bytes, fullBlocks);
+    }
+
+    unsigned char tail[128];
+    std::size_t tailBlocks = padTail(bytes + fullBlocks * 64, len % 64,
+                                     static_cast<std::uint64_t>(len) * 8, tail);
+    compress(state, tail, tailBlocks);
+    return digestFromState(state);
+}
+
+// Processa até 8 mensagens com o AVX2. Os passos em comum rodam em paralelo;
+// o que sobra das mensagens mais longas termina no backend escalar.
+void hashGroupAvx2(const void* const* data, const std::size_t* sizes,
+                   Sha256::Digest* out, std::size_t count) {
+    std::uint32_t states[Sha256::lanes][8];
+    unsigned char tails[Sha256::lanes][128];
+    Sha256Backends::LaneCursor cursors[Sha256::lanes];
+    std::size_t totalSteps[Sha256::lanes];
+
+    for (std::size_t lane = 0; lane < Sha256::lanes; ++lane) {
+        // Lanes sem mensagem repetem a primeira e o resultado é descartado
+        std::size_t source = lane < count ? lane : 0;
+        const auto* bytes = static_cast<const unsigned char*>(data[source]);
+        std::size_t len = sizes[source];
+        std::size_t fullBlocks = len / 64;
+
+        std::memcpy(states[lane], Sha256Backends::initialState, sizeof(states[lane]));
+        std::size_t tailBlocks = padTail(bytes + fullBlocks * 64, len % 64,
+                                         static_cast<std::uint64_t>(len) * 8, tails[lane]);
+        cursors[lane] = Sha256Backends::LaneCursor{bytes, fullBlocks, tails[lane]};
+        totalSteps[lane] = fullBlocks + tailBlocks;
+    }
+
+    std::size_t commonSteps = *std::min_element(totalSteps, totalSteps + Sha256::lanes);
+    Sha256Backends::compressAvx2x8(states, cursors, commonSteps);
+
+    for (std::size_t lane = 0; lane < count; ++lane) {
+        const Sha256Backends::LaneCursor& cursor = cursors[lane];
+        for (std::size_t step = commonSteps; step < totalSteps[lane]; ++step) {
+            const unsigned char* block = step < cursor.fullBlocks
+                ? cursor.data + step * 64
+                : cursor.tail + (step - cursor.fullBlocks) * 64;
+            Sha256Backends::compressScalar(states[lane], block, 1);
+        }
+        out[lane] = digestFromState(states[lane]);
+    }
+}
+
+void hashManyWith(Sha256::Backend backend, const void* const* data, const std::size_t* sizes,
+                  Sha256::Digest* out, std::size_t count) {
+    if (backend != Sha256::Backend::Avx2) {
+        CompressFn compress = compressFor(backend);
+        for (std::size_t i = 0; i < count; ++i) {
+            out[i] = hashOneWith(compress, data[i], sizes[i]);
+        }
+        return;
+    }
+
+    for (std::size_t first = 0; first < count; first += Sha256::lanes) {
+        std::size_t groupSize = std::min(Sha256::lanes, count - first);
+        if (groupSize == 1) {
+            out[first] = hashOneWith(Sha256Backends::compressScalar, data[first], sizes[first]);
+        } else {
+            hashGroupAvx2(data + first, sizes + first, out + first, groupSize);
+        }
+    }
+}
+
+// ---------------------------------------------
+// Vetores de teste (FIPS 180-4 / NIST) e comparação com o escalar
+// ---------------------------------------------
+
+struct TestVector {
+    const char* message;
+    unsigned char digest[32];
+};
+
+const TestVector knownVectors[] = {
+    {"",
+     {0xe3, 0xb0, 0xc4, 0x42, 0x98, 0xfc, 0x1c, 0x14, 0x9a, 0xfb, 0xf4, 0xc8, 0x99, 0x6f, 0xb9, 0x24,
+      0x27, 0xae, 0x41, 0xe4, 0x64, 0x9b, 0x93, 0x4c, 0xa4, 0x95, 0x99, 0x1b, 0x78, 0x52, 0xb8, 0x55}},
+    {"abc",
+     {0xba, 0x78, 0x16, 0xbf, 0x8f, 0x01, 0xcf, 0xea, 0x41, 0x41, 0x40, 0xde, 0x5d, 0xae, 0x22, 0x23,
+      0xb0, 0x03, 0x61, 0xa3, 0x96, 0x17, 0x7a, 0x9c, 0xb4, 0x10, 0xff, 0x61, 0xf2, 0x00, 0x15, 0xad}},
+    {"abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq",
+     {0x24, 0x8d, 0x6a, 0x61, 0xd2, 0x06, 0x38, 0xb8, 0xe5, 0xc0, 0x26, 0x93, 0x0c, 0x3e, 0x60, 0x39,
+      0xa3, 0x3c, 0xe4, 0x59, 0x64, 0xff, 0x21, 0x67, 0xf6, 0xec, 0xed, 0xd4, 0x19, 0xdb, 0x06, 0xc1}},
+    {"abcdefghbcdefghicdefghijdefghijkefghijklfghijklmghijklmnhijklmnoijklmnopjklmnopqklmnopqrlmnopqrsmnopqrstnopqrstu",
+     {0xcf, 0x5b, 0x16, 0xa7, 0x78, 0xaf, 0x83, 0x80, 0x03, 0x6c, 0xe5, 0x9e, 0x7b, 0x04, 0x92, 0x37,
+      0x0b, 0x24, 0x9b, 0x11, 0xe8, 0xf0, 0x7a, 0x51, 0xaf, 0xac, 0x45, 0x03, 0x7a, 0xfe, 0xe9, 0xd1}},
+};
+
+bool passesSelfTest(Sha256::Backend backend) {
+    constexpr std::size_t vectorCount = sizeof(knownVectors) / sizeof(knownVectors[0]);
+    const void* messages[vectorCount];
+    std::size_t sizes[vectorCount];
+    Sha256::Digest digests[vectorCount];
+    for (std::size_t i = 0; i < vectorCount; ++i) {
+        messages[i] = knownVectors[i].message;
+        sizes[i] = std::strlen(knownVectors[i].message);
+    }
+    hashManyWith(backend, messages, sizes, digests, vectorCount);
+    for (std::size_t i = 0; i < vectorCount; ++i) {
+        if (std::memcmp(digests[i].data(), knownVectors[i].digest, 32) != 0) {
+            return false;
+        }
+    }
+
+    // Tamanhos nas bordas do padding e mensagens de comprimentos diferentes
+    // no mesmo grupo, comparados com o backend escalar
+    unsigned char sample[1024];
+    std::uint32_t seed = 0x9e3779b9;
+    for (unsigned char& byte : sample) {
+        seed = seed * 1664525 + 1013904223;
+        byte = static_cast<unsigned char>(seed >> 24);
+    }
+    const std::size_t lengths[] = {0, 1, 55, 56, 63, 64, 65, 119, 120, 127, 128, 200, 511, 1024,
+                                   1000, 1000, 1000, 1000, 1000, 1000, 1000, 1000};
+    constexpr std::size_t lengthCount = sizeof(lengths) / sizeof(lengths[0]);
+    const void* samples[lengthCount];
+    Sha256::Digest sampleDigests[lengthCount];
+    for (std::size_t i = 0; i < lengthCount; ++i) {
+        samples[i] = sample + (sizeof(sample) - lengths[i]);
+    }
+    hashManyWith(backend, samples, lengths, sampleDigests, lengthCount);
+    for (std::size_t i = 0; i < lengthCount; ++i) {
+        if (sampleDigests[i] != hashOneWith(Sha256Backends::compressScalar, samples[i], lengths[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void selectBackend() {
+    shaNiVerified = Sha256Backends::cpuHasShaNi() && passesSelfTest(Sha256::Backend::ShaNi);
+    avx2Verified = Sha256Backends::cpuHasAvx2() && passesSelfTest(Sha256::Backend::Avx2);
+
+    Sha256::Backend best = Sha256::Backend::Scalar;
+    if (shaNiVerified) {
+        best = Sha256::Backend::ShaNi;
+    } else if (avx2Verified) {
+        best = Sha256::Backend::Avx2;
+    }
+    activeBackend.store(best);
+    activeCompress.store(compressFor(best));
+}
+
+CompressFn currentCompress() {
+    std::call_once(selectionFlag, selectBackend);
+    return activeCompress.load(std::memory_order_relaxed);
+}
+
+} // namespace
+
+Sha256::Sha256() {
+    reset();
+}
+
+void Sha256::update(const unsigned char* data, std::size_t len) {
+    CompressFn compress = currentCompress();
+    totalBits += static_cast<std::uint64_t>(len) * 8;
+
+    if (bufferLen > 0) {
+        std::size_t copyLen = std::min(len, blockSize - bufferLen);
+        std::memcpy(buffer.data() + bufferLen, data, copyLen);
+        bufferLen += copyLen;
+        data += copyLen;
+        len -= copyLen;
+        if (bufferLen < blockSize) {
+            return;
+        }
+        compress(state.data(), buffer.data(), 1);
+        bufferLen = 0;
+    }
+
+    // Blocos completos são comprimidos direto da entrada, sem cópia
+    std::size_t fullBlocks = len / blockSize;
+    if (fullBlocks > 0) {
+        compress(state.data(), data, fullBlocks);
+        data += fullBlocks * blockSize;
+        len -= fullBlocks * blockSize;
+    }
+
+    if (len > 0) {
+        std::memcpy(buffer.data(), data, len);
+        bufferLen = len;
+    }
+}
+
+Sha256::Digest Sha256::finalize() {
+    unsigned char tail[128];
+    std::size_t tailBlocks = padTail(buffer.data(), bufferLen, totalBits, tail);
+    currentCompress()(state.data(), tail, tailBlocks);
+
+    Digest digest = digestFromState(state.data());
+    reset();
+    return digest;
+}
+
+Sha256::Digest Sha256::hash(const void* data, std::size_t len) {
+    return hashOneWith(currentCompress(), data, len);
+}
+
+void Sha256::hashMany(const void* const* data, const std::size_t* sizes,
+                      Digest* out, std::size_t count) {
+    currentCompress();
+    hashManyWith(activeBackend.load(std::memory_order_relaxed), data, sizes, out, count);
+}
+
+Sha256::Backend Sha256::backend() {
+    currentCompress();
+    return activeBackend.load();
+}
+
+bool Sha256::setBackend(Backend backend) {
+    currentCompress();
+    if (!isSupported(backend)) {
+        return false;
+    }
+    activeBackend.store(backend);
+    activeCompress.store(compressFor(backend));
+    return true;
+}
+
+bool Sha256::isSupported(Backend backend) {
+    currentCompress();
+    switch (backend) {
+        case Backend::Scalar:
+            return true;
+        case Backend::ShaNi:
+            return shaNiVerified;
+        case Backend::Avx2:
+            return avx2Verified;
+    }
+    return false;
+}
+
+const char* Sha256::backendName(Backend backend) {
+    switch (backend) {
+        case Backend::Scalar:
+            return "scalar";
+        case Backend::ShaNi:
+            return "sha-ni";
+        case Backend::Avx2:
+            return "avx2-x8";
+    }
+    return "?";
+}
+
+void Sha256::reset() {
+    std::copy(std::begin(Sha256Backends::initialState), std::end(Sha256Backends::initialState),
+              state.begin());
+    buffer.fill(0);
+    bufferLen = 0;
+    totalBits = 0;
+}
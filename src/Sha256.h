@@ -0,0 +1,53 @@
+#ifndef SHA256_H
+#define SHA256_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// SHA-256 (FIPS 180-4) com despacho em tempo de execução:
+// - Scalar: implementação portável, sempre disponível (fallback)
+// - ShaNi:  instruções SHA do x86 para um único fluxo
+// - Avx2:   multi-buffer, 8 mensagens independentes por vez (só em hashMany)
+// Na primeira utilização o melhor backend suportado pela CPU é escolhido,
+// desde que passe pelos vetores de teste conhecidos.
+class Sha256 {
+public:
+    using Digest = std::array<unsigned char, 32>;
+
+    enum class Backend { Scalar, ShaNi, Avx2 };
+
+    // Mensagens processadas em paralelo pelo backend multi-buffer
+    static constexpr std::size_t lanes = 8;
+
+    Sha256();
+
+    void update(const unsigned char* data, std::size_t len);
+    Digest finalize();
+
+    // Hash de um único trecho de memória
+    static Digest hash(const void* data, std::size_t len);
+
+    // Hash de várias mensagens independentes (ex.: os blocos de um arquivo).
+    // Com Avx2 ativo as mensagens são processadas de 8 em 8.
+    static void hashMany(const void* const* data, const std::size_t* sizes,
+                         Digest* out, std::size_t count);
+
+    static Backend backend();
+    // Força um backend (benchmarks); retorna false se a CPU não suportar
+    // ou se o backend falhar nos vetores de teste
+    static bool setBackend(Backend backend);
+    static bool isSupported(Backend backend);
+    static const char* backendName(Backend backend);
+
+private:
+    static constexpr std::size_t blockSize = 64;
+    std::array<unsigned char, blockSize> buffer{};
+    std::size_t bufferLen = 0;
+    std::uint64_t totalBits = 0;
+    std::array<std::uint32_t, 8> state{};
+
+    void reset();
+};
+
+#endif
@@ -0,0 +1,313 @@
+#include "Sha256Backends.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SHA256_X86 1
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
+namespace Sha256Backends {
+
+namespace {
+
+std::uint32_t rotr(std::uint32_t value, std::uint32_t count) {
+    return (value >> count) | (value << (32 - count));
+}
+
+std::uint32_t choose(std::uint32_t x, std::uint32_t y, std::uint32_t z) {
+    return (x & y) ^ (~x & z);
+}
+
+std::uint32_t majority(std::uint32_t x, std::uint32_t y, std::uint32_t z) {
+    return (x & y) ^ (x & z) ^ (y & z);
+}
+
+std::uint32_t loadBigEndian(const unsigned char* bytes) {
+    return (static_cast<std::uint32_t>(bytes[0]) << 24) |
+           (static_cast<std::uint32_t>(bytes[1]) << 16) |
+           (static_cast<std::uint32_t>(bytes[2]) << 8) |
+           static_cast<std::uint32_t>(bytes[3]);
+}
+
+} // namespace
+
+void compressScalar(std::uint32_t* state, const unsigned char* data, std::size_t blocks) {
+    for (; blocks > 0; --blocks, data += 64) {
+        std::uint32_t w[64];
+        for (int i = 0; i < 16; ++i) {
+            w[i] = loadBigEndian(data + i * 4);
+        }
+
+        for (int i = 16; i < 64; ++i) {
+            std::uint32_t s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+            std::uint32_t s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+            w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+        }
+
+        std::uint32_t a = state[0];
+        std::uint32_t b = state[1];
+        std::uint32_t c = state[2];
+        std::uint32_t d = state[3];
+        std::uint32_t e = state[4];
+        std::uint32_t f = state[5];
+        std::uint32_t g = state[6];
+        std::uint32_t h = state[7];
+
+        for (int i = 0; i < 64; ++i) {
+            std::uint32_t S1 = rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25);
+            std::uint32_t ch = choose(e, f, g);
+            std::uint32_t temp1 = h + S1 + ch + roundConstants[i] + w[i];
+            std::uint32_t S0 = rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22);
+            std::uint32_t maj = majority(a, b, c);
+            std::uint32_t temp2 = S0 + maj;
+
+            h = g;
+            g = f;
+            f = e;
+            e = d + temp1;
+            d = c;
+            c = b;
+            b = a;
+            a = temp1 + temp2;
+        }
+
+        state[0] += a;
+        state[1] += b;
+        state[2] += c;
+        state[3] += d;
+        state[4] += e;
+        state[5] += f;
+        state[6] += g;
+        state[7] += h;
+    }
+}
+
+#ifdef SHA256_X86
+
+// Intel SHA Extensions: cada sha256rnds2 faz duas rodadas, com o estado
+// reorganizado nos registradores ABEF/CDGH
+__attribute__((target("sha,sse4.1")))
+void compressShaNi(std::uint32_t* state, const unsigned char* data, std::size_t blocks) {
+    const __m128i byteSwap = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+
+    __m128i tmp = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&state[0]));
+    __m128i state1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&state[4]));
+    tmp = _mm_shuffle_epi32(tmp, 0xB1);               // CDAB
+    state1 = _mm_shuffle_epi32(state1, 0x1B);         // EFGH
+    __m128i state0 = _mm_alignr_epi8(tmp, state1, 8); // ABEF
+    state1 = _mm_blend_epi16(state1, tmp, 0xF0);      // CDGH
+
+    for (; blocks > 0; --blocks, data += 64) {
+        const __m128i abefSave = state0;
+        const __m128i cdghSave = state1;
+        __m128i msg[4];
+
+        // 16 grupos de 4 rodadas; a expansão da mensagem roda junto,
+        // sempre um grupo à frente
+        for (int group = 0; group < 16; ++group) {
+            __m128i& current = msg[group % 4];
+            if (group < 4) {
+                current = _mm_shuffle_epi8(
+                    _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + group * 16)), byteSwap);
+            }
+
+            __m128i words = _mm_add_epi32(
+                current, _mm_loadu_si128(reinterpret_cast<const __m128i*>(&roundConstants[group * 4])));
+            state1 = _mm_sha256rnds2_epu32(state1, state0, words);
+
+            if (group >= 3 && group <= 14) {
+                __m128i& next = msg[(group + 1) % 4];
+                tmp = _mm_alignr_epi8(current, msg[(group + 3) % 4], 4);
+                next = _mm_add_epi32(next, tmp);
+                next = _mm_sha256msg2_epu32(next, current);
+            }
+
+            words = _mm_shuffle_epi32(words, 0x0E);
+            state0 = _mm_sha256rnds2_epu32(state0, state1, words);
+
+            if (group >= 1 && group <= 12) {
+                __m128i& previous = msg[(group + 3) % 4];
+                previous = _mm_sha256msg1_epu32(previous, current);
+            }
+        }
+
+        state0 = _mm_add_epi32(state0, abefSave);
+        state1 = _mm_add_epi32(state1, cdghSave);
+    }
+
+    tmp = _mm_shuffle_epi32(state0, 0x1B);          // FEBA
+    state1 = _mm_shuffle_epi32(state1, 0xB1);       // DCHG
+    state0 = _mm_blend_epi16(tmp, state1, 0xF0);    // DCBA
+    state1 = _mm_alignr_epi8(state1, tmp, 8);       // HGFE
+
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(&state[0]), state0);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(&state[4]), state1);
+}
+
+namespace {
+
+__attribute__((target("avx2")))
+inline __m256i rotr8(__m256i value, int count) {
+    return _mm256_or_si256(_mm256_srli_epi32(value, count), _mm256_slli_epi32(value, 32 - count));
+}
+
+} // namespace
+
+// Multi-buffer: cada lane de 32 bits do registrador AVX2 carrega uma mensagem
+// diferente, então as 64 rodadas do SHA-256 avançam 8 hashes de uma vez
+__attribute__((target("avx2")))
+void compressAvx2x8(std::uint32_t (*states)[8], const LaneCursor* cursors, std::size_t steps) {
+    if (steps == 0) {
+        return;
+    }
+
+    // Transpõe os estados: v[i] guarda a palavra i das 8 mensagens
+    alignas(32) std::uint32_t lanesWords[8][8];
+    for (int word = 0; word < 8; ++word) {
+        for (int lane = 0; lane < 8; ++lane) {
+            lanesWords[word][lane] = states[lane][word];
+        }
+    }
+    __m256i v[8];
+    for (int word = 0; word < 8; ++word) {
+        v[word] = _mm256_load_si256(reinterpret_cast<const __m256i*>(lanesWords[word]));
+    }
+
+    for (std::size_t step = 0; step < steps; ++step) {
+        const unsigned char* block[8];
+        for (int lane = 0; lane < 8; ++lane) {
+            const LaneCursor& cursor = cursors[lane];
+            block[lane] = step < cursor.fullBlocks
+                ? cursor.data + step * 64
+                : cursor.tail + (step - cursor.fullBlocks) * 64;
+        }
+
+        __m256i w[64];
+        for (int i = 0; i < 16; ++i) {
+            w[i] = _mm256_setr_epi32(
+                static_cast<int>(loadBigEndian(block[0] + i * 4)),
+                static_cast<int>(loadBigEndian(block[1] + i * 4)),
+                static_cast<int>(loadBigEndian(block[2] + i * 4)),
+                static_cast<int>(loadBigEndian(block[3] + i * 4)),
+                static_cast<int>(loadBigEndian(block[4] + i * 4)),
+                static_cast<int>(loadBigEndian(block[5] + i * 4)),
+                static_cast<int>(loadBigEndian(block[6] + i * 4)),
+                static_cast<int>(loadBigEndian(block[7] + i * 4)));
+        }
+        for (int i = 16; i < 64; ++i) {
+            __m256i s0 = _mm256_xor_si256(_mm256_xor_si256(rotr8(w[i - 15], 7), rotr8(w[i - 15], 18)),
+                                          _mm256_srli_epi32(w[i - 15], 3));
+            __m256i s1 = _mm256_xor_si256(_mm256_xor_si256(rotr8(w[i - 2], 17), rotr8(w[i - 2], 19)),
+                                          _mm256_srli_epi32(w[i - 2], 10));
+            w[i] = _mm256_add_epi32(_mm256_add_epi32(w[i - 16], s0), _mm256_add_epi32(w[i - 7], s1));
+        }
+
+        __m256i a = v[0], b = v[1], c = v[2], d = v[3];
+        __m256i e = v[4], f = v[5], g = v[6], h = v[7];
+
+        for (int i = 0; i < 64; ++i) {
+            __m256i S1 = _mm256_xor_si256(_mm256_xor_si256(rotr8(e, 6), rotr8(e, 11)), rotr8(e, 25));
+            __m256i ch = _mm256_xor_si256(_mm256_and_si256(e, f), _mm256_andnot_si256(e, g));
+            __m256i temp1 = _mm256_add_epi32(
+                _mm256_add_epi32(h, S1),
+                _mm256_add_epi32(_mm256_add_epi32(ch, w[i]),
+                                 _mm256_set1_epi32(static_cast<int>(roundConstants[i]))));
+            __m256i S0 = _mm256_xor_si256(_mm256_xor_si256(rotr8(a, 2), rotr8(a, 13)), rotr8(a, 22));
+            __m256i maj = _mm256_xor_si256(_mm256_xor_si256(_mm256_and_si256(a, b), _mm256_and_si256(a, c)),
+                                           _mm256_and_si256(b, c));
+            __m256i temp2 = _mm256_add_epi32(S0, maj);
+
+            h = g;
+            g = f;
+            f = e;
+            e = _mm256_add_epi32(d, temp1);
+            d = c;
+            c = b;
+            b = a;
+            a = _mm256_add_epi32(temp1, temp2);
+        }
+
+        v[0] = _mm256_add_epi32(v[0], a);
+        v[1] = _mm256_add_epi32(v[1], b);
+        v[2] = _mm256_add_epi32(v[2], c);
+        v[3] = _mm256_add_epi32(v[3], d);
+        v[4] = _mm256_add_epi32(v[4], e);
+        v[5] = _mm256_add_epi32(v[5], f);
+        v[6] = _mm256_add_epi32(v[6], g);
+        v[7] = _mm256_add_epi32(v[7], h);
+    }
+
+    for (int word = 0; word < 8; ++word) {
+        _mm256_store_si256(reinterpret_cast<__m256i*>(lanesWords[word]), v[word]);
+        for (int lane = 0; lane < 8; ++lane) {
+            states[lane][word] = lanesWords[word][lane];
+        }
+    }
+}
+
+bool cpuHasShaNi() {
+    unsigned int eax, ebx, ecx, edx;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+        return false;
+    }
+    if (!(ecx & bit_SSSE3) || !(ecx & bit_SSE4_1)) {
+        return false;
+    }
+    if (__get_cpuid_max(0, nullptr) < 7) {
+        return false;
+    }
+    __cpuid_count(7, 0, eax, ebx, ecx, edx);
+    return (ebx & bit_SHA) != 0;
+}
+
+bool cpuHasAvx2() {
+    unsigned int eax, ebx, ecx, edx;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+        return false;
+    }
+    // O sistema operacional precisa salvar os registradores YMM (XCR0 bits 1 e 2)
+    if (!(ecx & bit_OSXSAVE) || !(ecx & bit_AVX)) {
+        return false;
+    }
+    unsigned int xcr0Low, xcr0High;
+    __asm__ volatile("xgetbv" : "=a"(xcr0Low), "=d"(xcr0High) : "c"(0));
+    (void)xcr0High;
+    if ((xcr0Low & 0x6) != 0x6) {
+        return false;
+    }
+    if (__get_cpuid_max(0, nullptr) < 7) {
+        return false;
+    }
+    __cpuid_count(7, 0, eax, ebx, ecx, edx);
+    return (ebx & bit_AVX2) != 0;
+}
+
+#else
+
+// Fora do x86 só o backend portável existe; estas funções nunca são escolhidas
+void compressShaNi(std::uint32_t* state, const unsigned char* data, std::size_t blocks) {
+    compressScalar(state, data, blocks);
+}
+
+void compressAvx2x8(std::uint32_t (*states)[8], const LaneCursor* cursors, std::size_t steps) {
+    for (int lane = 0; lane < 8; ++lane) {
+        for (std::size_t step = 0; step < steps; ++step) {
+            const LaneCursor& cursor = cursors[lane];
+            compressScalar(states[lane], step < cursor.fullBlocks
+                ? cursor.data + step * 64
+                : cursor.tail + (step - cursor.fullBlocks) * 64, 1);
+        }
+    }
+}
+
+bool cpuHasShaNi() {
+    return false;
+}
+
+bool cpuHasAvx2() {
+    return false;
+}
+
+#endif
+
+}
@@ -0,0 +1,185 @@
+#include "StorageBackend.h"
+
+#include "IoUringBackend.h"
+#include "Log.h"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// pread/pwrite repetidos até transferir tudo, chegar ao fim do arquivo ou falhar
+ssize_t transfer(bool write, int fd, std::uint8_t* buffer, std::size_t length, off_t offset) {
+    std::size_t done = 0;
+    while (done < length) {
+        ssize_t result = write ? pwrite(fd, buffer + done, length - done, offset + static_cast<off_t>(done))
+                               : pread(fd, buffer + done, length - done, offset + static_cast<off_t>(done));
+        if (result < 0 && errno == EINTR) {
+            continue;
+        }
+        if (result < 0) {
+            return -errno;
+        }
+        if (result == 0) {
+            break;
+        }
+        done += static_cast<std::size_t>(result);
+    }
+    return static_cast<ssize_t>(done);
+}
+
+class SyncBackend : public StorageBackend {
+public:
+    void read(int fd, void* buffer, std::size_t length, off_t offset, Completion done) override {
+        run(false, fd, static_cast<std::uint8_t*>(buffer), length, offset, done);
+    }
+    void write(int fd, const void* buffer, std::size_t length, off_t offset, Completion done) override {
+        run(true, fd, static_cast<std::uint8_t*>(const_cast<void*>(buffer)), length, offset, done);
+    }
+
+    const char* name() const override { return "sync"; }
+    Stats stats() const override {
+        Stats result;
+        result.operations = operations.load(std::memory_order_relaxed);
+        result.submitCalls = result.operations;
+        return result;
+    }
+
+private:
+    std::atomic<std::uint64_t> operations { 0 };
+
+    void run(bool write, int fd, std::uint8_t* buffer, std::size_t length, off_t offset, const Completion& done) {
+        operations.fetch_add(1, std::memory_order_relaxed);
+        done(transfer(write, fd, buffer, length, offset));
+    }
+};
+
+// Fila única atendida por um número fixo de threads; cada uma faz a operação
+// inteira (pread/pwrite bloqueante) e chama a conclusão
+class ThreadPoolBackend : public StorageBackend {
+public:
+    explicit ThreadPoolBackend(unsigned threadCount) {
+        threadCount = std::max(1u, threadCount);
+        for (unsigned i = 0; i < threadCount; ++i) {
+            workers.emplace_back(&ThreadPoolBackend::workerLoop, this);
+        }
+    }
+
+    ~ThreadPoolBackend() override {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+
+    void read(int fd, void* buffer, std::size_t length, off_t offset, Completion done) override {
+        enqueue({false, fd, static_cast<std::uint8_t*>(buffer), length, offset, std::move(done)});
+    }
+    void write(int fd, const void* buffer, std::size_t length, off_t offset, Completion done) override {
+        enqueue({true, fd, static_cast<std::uint8_t*>(const_cast<void*>(buffer)), length, offset, std::move(done)});
+    }
+
+    const char* name() const override { return "threads"; }
+    Stats stats() const override {
+        Stats result;
+        result.operations = operations.load(std::memory_order_relaxed);
+        result.submitCalls = result.operations;
+        return result;
+    }
+
+private:
+    struct Request {
+        bool write;
+        int fd;
+        std::uint8_t* buffer;
+        std::size_t length;
+        off_t offset;
+        Completion done;
+    };
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<Request> queue;
+    bool stopping = false;
+    std::vector<std::thread> workers;
+    std::atomic<std::uint64_t> operations { 0 };
+
+    void enqueue(Request request) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            queue.push_back(std::move(request));
+        }
+        operations.fetch_add(1, std::memory_order_relaxed);
+        wake.notify_one();
+    }
+
+    void workerLoop() {
+        while (true) {
+            Request request;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                // Ao encerrar, a fila é esvaziada antes de as threads saírem
+                wake.wait(lock, [this] { return stopping || !queue.empty(); });
+                if (queue.empty()) {
+                    return;
+                }
+                request = std::move(queue.front());
+                queue.pop_front();
+            }
+            request.done(transfer(request.write, request.fd, request.buffer, request.length, request.offset));
+        }
+    }
+};
+
+}
+
+std::unique_ptr<StorageBackend> StorageBackend::create(Kind kind, unsigned threads, unsigned queueDepth) {
+    if (threads == 0) {
+        threads = std::max(2u, std::thread::hardware_concurrency());
+    }
+
+    switch (kind) {
+        case Kind::Sync:
+            return std::make_unique<SyncBackend>();
+        case Kind::ThreadPool:
+            return std::make_unique<ThreadPoolBackend>(threads);
+        case Kind::IoUring:
+        case Kind::Auto:
+            try {
+                return std::make_unique<IoUringBackend>(queueDepth);
+            } catch (const std::exception& e) {
+                if (kind == Kind::IoUring) {
+                    Log::warn("[Disco] ", e.what(), "; usando o pool de threads");
+                }
+            }
+            return std::make_unique<ThreadPoolBackend>(threads);
+    }
+    return std::make_unique<ThreadPoolBackend>(threads);
+}
+
+bool StorageBackend::parseKind(const std::string& text, Kind& kind) {
+    if (text == "auto") {
+        kind = Kind::Auto;
+    } else if (text == "uring" || text == "io_uring") {
+        kind = Kind::IoUring;
+    } else if (text == "threads") {
+        kind = Kind::ThreadPool;
+    } else if (text == "sync") {
+        kind = Kind::Sync;
+    } else {
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,50 @@
+#ifndef STORAGE_BACKEND_H
+#define STORAGE_BACKEND_H
+
+#include <sys/types.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+// Leituras e escritas de blocos em disco fora das threads de rede. Cada operação
+// é submetida com um buffer que deve continuar válido até a conclusão, e a
+// conclusão é entregue em uma thread do backend. Transferências parciais são
+// completadas pelo próprio backend: o resultado é o total transferido (menor que
+// o pedido só no fim do arquivo) ou -errno.
+class StorageBackend {
+public:
+    enum class Kind {
+        // io_uring quando o kernel suporta; senão, pool de threads
+        Auto,
+        IoUring,
+        ThreadPool,
+        // Executa na própria thread que submete (comportamento antigo)
+        Sync
+    };
+
+    using Completion = std::function<void(ssize_t result)>;
+
+    struct Stats {
+        std::uint64_t operations = 0;
+        // Syscalls de submissão (io_uring_enter) ou despachos para as threads;
+        // operations / submitCalls é o tamanho médio dos lotes
+        std::uint64_t submitCalls = 0;
+    };
+
+    virtual ~StorageBackend() = default;
+
+    virtual void read(int fd, void* buffer, std::size_t length, off_t offset, Completion done) = 0;
+    virtual void write(int fd, const void* buffer, std::size_t length, off_t offset, Completion done) = 0;
+
+    virtual const char* name() const = 0;
+    virtual Stats stats() const = 0;
+
+    // O destrutor espera as operações pendentes terminarem
+    static std::unique_ptr<StorageBackend> create(Kind kind, unsigned threads = 0, unsigned queueDepth = 64);
+    static bool parseKind(const std::string& text, Kind& kind);
+};
+
+#endif
@@ -0,0 +1,159 @@
+#include "UploadScheduler.h"
+
+#include <algorithm>
+#include <utility>
+
+UploadScheduler::UploadScheduler(std::size_t slots, std::size_t optimisticRounds)
+    : slots(slots), optimisticRounds(std::max<std::size_t>(optimisticRounds, 1)) {}
+
+UploadScheduler::Entry& UploadScheduler::entryLocked(const EventServer::ConnectionPtr& connection) {
+    Entry& entry = entries[connection.get()];
+    if (entry.connection.lock() != connection) {
+        entry = Entry{};
+        entry.connection = connection;
+    }
+    return entry;
+}
+
+std::size_t UploadScheduler::regularUnchokedLocked() const {
+    std::size_t count = 0;
+    for (const auto& item : entries) {
+        const Entry& entry = item.second;
+        if (entry.interested && !entry.choked && !entry.optimistic) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+void UploadScheduler::identify(const EventServer::ConnectionPtr& connection, int neighbor) {
+    if (!enabled()) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    entryLocked(connection).neighbor = neighbor;
+}
+
+bool UploadScheduler::admit(const EventServer::ConnectionPtr& connection) {
+    if (!enabled()) {
+        return true;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    Entry& entry = entryLocked(connection);
+    ++entry.requests;
+    if (entry.interested) {
+        return !entry.choked;
+    }
+    // Conexão sem interesse está liberada; ao pedir, disputa um slot
+    entry.interested = true;
+    if (regularUnchokedLocked() <= slots) {
+        return true;
+    }
+    setChokedLocked(entry, true);
+    return false;
+}
+
+void UploadScheduler::setChokedLocked(Entry& entry, bool choked) {
+    if (entry.choked == choked) {
+        return;
+    }
+    entry.choked = choked;
+    ++(choked ? chokes : unchokes);
+    // Enviado sob o lock: CHOKE e UNCHOKE de threads diferentes chegam na ordem das decisões
+    if (auto connection = entry.connection.lock()) {
+        connection->send(choked ? Protocol::MessageType::CHOKE : Protocol::MessageType::UNCHOKE,
+                         std::vector<std::uint8_t>{});
+    }
+}
+
+void UploadScheduler::recordUpload(const EventServer::Connection& connection, std::size_t bytes) {
+    if (!enabled()) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = entries.find(&connection);
+    if (it != entries.end()) {
+        it->second.uploaded += bytes;
+    }
+}
+
+void UploadScheduler::rechoke(const std::vector<std::uint64_t>& fetchedFrom, bool seeding) {
+    if (!enabled()) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    ++rounds;
+
+    // Taxa de cada conexão interessada na rodada que terminou
+    std::vector<std::pair<std::uint64_t, Entry*>> candidates;
+    for (auto it = entries.begin(); it != entries.end();) {
+        Entry& entry = it->second;
+        auto connection = entry.connection.lock();
+        if (!connection || connection->isClosed()) {
+            it = entries.erase(it);
+            continue;
+        }
+        std::uint64_t fetched = 0;
+        if (entry.neighbor >= 0 && static_cast<std::size_t>(entry.neighbor) < fetchedFrom.size()) {
+            fetched = fetchedFrom[entry.neighbor];
+        }
+        std::uint64_t rate = seeding ? entry.uploaded : fetched - entry.lastFetched;
+        entry.lastFetched = fetched;
+        // Liberada e sem pedir nada: não precisa mais de slot
+        if (entry.interested && !entry.choked && entry.requests == 0) {
+            entry.interested = false;
+        }
+        entry.requests = 0;
+        entry.uploaded = 0;
+        if (entry.interested) {
+            candidates.emplace_back(rate, &entry);
+        }
+        ++it;
+    }
+
+    // Maiores taxas primeiro; o embaralhamento desfaz empates ao acaso
+    std::shuffle(candidates.begin(), candidates.end(), rng);
+    std::stable_sort(candidates.begin(), candidates.end(),
+                     [](const auto& a, const auto& b) { return a.first > b.first; });
+
+    // O otimista atual continua até o fim do seu turno se ainda estiver
+    // interessado e fora dos slots regulares
+    Entry* optimistic = nullptr;
+    bool rotate = rounds % optimisticRounds == 0;
+    for (std::size_t i = slots; i < candidates.size() && !rotate; ++i) {
+        if (candidates[i].second->optimistic) {
+            optimistic = candidates[i].second;
+        }
+    }
+    if (!optimistic && candidates.size() > slots) {
+        std::size_t pick = std::uniform_int_distribution<std::size_t>(slots, candidates.size() - 1)(rng);
+        optimistic = candidates[pick].second;
+    }
+
+    for (auto& item : entries) {
+        item.second.optimistic = false;
+        if (!item.second.interested) {
+            setChokedLocked(item.second, false);
+        }
+    }
+    for (std::size_t i = 0; i < candidates.size(); ++i) {
+        Entry& entry = *candidates[i].second;
+        entry.optimistic = &entry == optimistic;
+        setChokedLocked(entry, i >= slots && !entry.optimistic);
+    }
+}
+
+UploadScheduler::Stats UploadScheduler::stats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    Stats result;
+    result.connections = entries.size();
+    for (const auto& item : entries) {
+        const Entry& entry = item.second;
+        result.interested += entry.interested ? 1 : 0;
+        result.unchoked += entry.interested && !entry.choked ? 1 : 0;
+    }
+    result.rounds = rounds;
+    result.chokes = chokes;
+    result.unchokes = unchokes;
+    return result;
+}
@@ -0,0 +1,88 @@
+#ifndef UPLOAD_SCHEDULER_H
+#define UPLOAD_SCHEDULER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include "EventServer.h"
+
+// Escalonador de upload (choke/unchoke, como no BitTorrent). Só um número fixo
+// de conexões interessadas recebe blocos ao mesmo tempo; as demais ficam em
+// choke e não pedem nada até receber UNCHOKE. A cada rodada (rechoke) os slots
+// vão para quem mais nos enviou blocos na rodada anterior (tit-for-tat) ou,
+// quando o peer só semeia, para quem mais recebeu de nós. Um slot extra,
+// otimista, gira entre as conexões em choke para descobrir parceiros melhores e
+// dar a primeira chance a quem ainda não tem nada para oferecer.
+//
+// Interesse: uma conexão passa a disputar um slot no primeiro REQUEST_BLOCK
+// (admit) e deixa de disputar quando passa uma rodada inteira sem pedir nada.
+// Conexões sem interesse ficam sempre liberadas, para poderem pedir de novo.
+class UploadScheduler {
+public:
+    struct Stats {
+        std::size_t connections = 0;
+        std::size_t interested = 0;
+        std::size_t unchoked = 0;
+        std::uint64_t rounds = 0;
+        std::uint64_t chokes = 0;
+        std::uint64_t unchokes = 0;
+    };
+
+    // slots = 0 desliga o controle: toda conexão é atendida.
+    // O slot otimista troca de dono a cada optimisticRounds rodadas.
+    UploadScheduler(std::size_t slots, std::size_t optimisticRounds);
+
+    bool enabled() const { return slots > 0; }
+
+    // Associa a conexão ao vizinho (índice na lista de vizinhos, -1 se não for
+    // um deles) pelo endereço de escuta informado no HANDSHAKE
+    void identify(const EventServer::ConnectionPtr& connection, int neighbor);
+    // Pedido de bloco. Retorna false se a conexão está em choke; quando a recusa
+    // é nova, envia CHOKE antes de o chamador responder ao pedido.
+    bool admit(const EventServer::ConnectionPtr& connection);
+    void recordUpload(const EventServer::Connection& connection, std::size_t bytes);
+
+    // Reavalia os slots e envia CHOKE/UNCHOKE para quem mudou de estado.
+    // fetchedFrom: bytes recebidos de cada vizinho desde o início (Metrics).
+    // seeding: nenhum download em andamento; ordena pelo upload para cada conexão.
+    void rechoke(const std::vector<std::uint64_t>& fetchedFrom, bool seeding);
+
+    Stats stats() const;
+
+private:
+    struct Entry {
+        std::weak_ptr<EventServer::Connection> connection;
+        int neighbor = -1;
+        bool interested = false;
+        bool choked = false;
+        bool optimistic = false;
+        // Pedidos e bytes enviados na rodada atual
+        std::uint64_t requests = 0;
+        std::uint64_t uploaded = 0;
+        // fetchedFrom[neighbor] na rodada anterior
+        std::uint64_t lastFetched = 0;
+    };
+
+    std::size_t slots;
+    std::size_t optimisticRounds;
+
+    mutable std::mutex mutex;
+    std::unordered_map<const EventServer::Connection*, Entry> entries;
+    std::mt19937 rng { std::random_device{}() };
+    std::uint64_t rounds = 0;
+    std::uint64_t chokes = 0;
+    std::uint64_t unchokes = 0;
+
+    // Entrada da conexão; recomeça se o endereço pertencia a uma conexão já fechada
+    Entry& entryLocked(const EventServer::ConnectionPtr& connection);
+    std::size_t regularUnchokedLocked() const;
+    // Muda o estado e avisa o cliente com CHOKE/UNCHOKE
+    void setChokedLocked(Entry& entry, bool choked);
+};
+
+#endif
@@ -1,7 +1,14 @@
+#include "ConnectionPool.h"
 #include "Peer.h"
 #include "FileProcessor.h"
+#include "Log.h"
+#include "Protocol.h"
+#include "StorageBackend.h"
 
+#include <csignal>
 #include <iostream>
+#include <string>
+#include <unistd.h>
 #include <vector>
 
 namespace {
@@ -9,8 +16,10 @@ constexpr std::size_t DEFAULT_BLOCK_SIZE = 1024;
 
 void printUsage(const char* binaryName) {
     std::cerr << "Uso:\n"
-              << "  " << binaryName << " --create-meta <arquivo> [tamanho_bloco]\n"
-              << "  " << binaryName << " [--meta <arquivo.meta>] <minha_porta> <ip_vizinho1> <porta_vizinho1> [<ip_vizinho2> <porta_vizinho2> ...]\n";
+              << "  " << binaryName << " --create-meta <arquivo> [tamanho_bloco] [--with-blocks] [--threads <n>]\n"
+              << "  " << binaryName << " --convert-meta <entrada.meta> <saida.meta> [--text]\n"
+              << "  " << binaryName << " --stats <ip> <porta>\n"
+              << "  " << binaryName << " [--meta <arquivo.meta> ...] [--want <checksum> ...] [--window <pedidos_pendentes>] [--endgame-blocks <n>] [--no-endgame] [--upload-slots <n>] [--choke-interval <segundos>] [--server-threads <n>] [--io-backend auto|uring|threads|sync] [--no-zero-copy] [--cache-mb <n>] [--block-files] [--journal-batch <blocos>] [--verify-resume] [--verify-threads <n>] [--max-frame <bytes>] [--stats-interval <segundos>] [--log-level debug|info|warn|error] <minha_porta> <ip_vizinho1> <porta_vizinho1> [<ip_vizinho2> <porta_vizinho2> ...]\n";
 }
 }
 
@@ -23,16 +32,31 @@ int main(int argc, char* argv[]) {
 
         try {
             std::size_t blockSize = DEFAULT_BLOCK_SIZE;
-            if (argc >= 4) {
-                blockSize = static_cast<std::size_t>(std::stoul(argv[3]));
+            FileProcessor::MetadataOptions options;
+            for (int i = 3; i < argc; ++i) {
+                std::string arg = argv[i];
+                if (arg == "--with-blocks") {
+                    options.writeBlockFiles = true;
+                } else if (arg == "--threads") {
+                    if (i + 1 >= argc) {
+                        printUsage(argv[0]);
+                        return 1;
+                    }
+                    options.threads = static_cast<unsigned>(std::stoul(argv[++i]));
+                } else {
+                    blockSize = static_cast<std::size_t>(std::stoul(arg));
+                }
             }
-            auto result = FileProcessor::createFileMetadata(argv[2], blockSize);
+            auto result = FileProcessor::createFileMetadata(argv[2], blockSize, options);
             std::cout << "Metadata gerada com sucesso!\n"
                       << "Arquivo original: " << result.content.info.fileName << " (" << result.content.info.fileSize << " bytes)\n"
-                      << "Blocos gerados: " << result.content.info.blockCount << " de tamanho " << result.content.info.blockSize << " bytes\n"
+                      << "Blocos: " << result.content.info.blockCount << " de tamanho " << result.content.info.blockSize << " bytes\n"
                       << "Checksum (SHA-256): " << result.content.info.checksum << "\n"
-                      << "Pasta dos blocos: " << result.content.blocksDirectory << "\n"
-                      << "Arquivo .meta: " << result.metadataPath << "\n";
+                      << "Arquivo servido: " << result.content.sourceFile << "\n";
+            if (options.writeBlockFiles) {
+                std::cout << "Pasta dos blocos: " << result.content.blocksDirectory << "\n";
+            }
+            std::cout << "Arquivo .meta: " << result.metadataPath << "\n";
         } catch (const std::exception& e) {
             std::cerr << "Erro ao gerar metadata: " << e.what() << "\n";
             return 1;
@@ -41,7 +65,57 @@ int main(int argc, char* argv[]) {
         return 0;
     }
 
-    std::string metadataPath;
+    if (argc >= 2 && std::string(argv[1]) == "--convert-meta") {
+        if (argc < 4) {
+            printUsage(argv[0]);
+            return 1;
+        }
+
+        try {
+            auto format = FileProcessor::MetadataFormat::Binary;
+            if (argc >= 5 && std::string(argv[4]) == "--text") {
+                format = FileProcessor::MetadataFormat::Text;
+            }
+            auto content = FileProcessor::loadMetadataFile(argv[2]);
+            FileProcessor::writeMetadataFile(content, argv[3], format);
+            std::cout << "Metadata convertida: " << argv[2] << " -> " << argv[3] << " ("
+                      << (format == FileProcessor::MetadataFormat::Binary ? "binário" : "texto") << ")\n";
+        } catch (const std::exception& e) {
+            std::cerr << "Erro ao converter metadata: " << e.what() << "\n";
+            return 1;
+        }
+
+        return 0;
+    }
+
+    if (argc >= 2 && std::string(argv[1]) == "--stats") {
+        if (argc < 4) {
+            printUsage(argv[0]);
+            return 1;
+        }
+
+        // Consulta as métricas de um peer em execução
+        NeighborInfo target{argv[2], std::stoi(argv[3])};
+        int sockfd = ConnectionPool::connectTo(target);
+        if (sockfd < 0) {
+            std::cerr << "Não foi possível conectar a " << target.ip << ":" << target.port << "\n";
+            return 1;
+        }
+        Protocol::MessageType type;
+        std::vector<std::uint8_t> payload;
+        bool received = Protocol::sendMessage(sockfd, Protocol::MessageType::STATS, nullptr, 0) &&
+                        Protocol::receiveMessage(sockfd, type, payload);
+        close(sockfd);
+        if (!received || type != Protocol::MessageType::STATS) {
+            std::cerr << "Resposta STATS inválida de " << target.ip << ":" << target.port << "\n";
+            return 1;
+        }
+        std::cout << std::string(payload.begin(), payload.end());
+        return 0;
+    }
+
+    std::vector<std::string> metadataPaths;
+    PeerConfig config;
     int argIndex = 1;
     while (argIndex < argc) {
         std::string arg = argv[argIndex];
@@ -50,8 +124,113 @@ int main(int argc, char* argv[]) {
                 printUsage(argv[0]);
                 return 1;
             }
-            metadataPath = argv[argIndex + 1];
+            metadataPaths.push_back(argv[argIndex + 1]);
+            argIndex += 2;
+        } else if (arg == "--want") {
+            if (argIndex + 1 >= argc) {
+                printUsage(argv[0]);
+                return 1;
+            }
+            config.wantedFiles.push_back(argv[argIndex + 1]);
+            argIndex += 2;
+        } else if (arg == "--upload-slots") {
+            if (argIndex + 1 >= argc) {
+                printUsage(argv[0]);
+                return 1;
+            }
+            config.uploadSlots = static_cast<std::size_t>(std::stoul(argv[argIndex + 1]));
+            argIndex += 2;
+        } else if (arg == "--choke-interval") {
+            if (argIndex + 1 >= argc) {
+                printUsage(argv[0]);
+                return 1;
+            }
+            config.chokeInterval = std::chrono::milliseconds(
+                static_cast<long long>(std::stod(argv[argIndex + 1]) * 1000));
+            argIndex += 2;
+        } else if (arg == "--no-endgame") {
+            config.endgame = false;
+            argIndex += 1;
+        } else if (arg == "--endgame-blocks") {
+            if (argIndex + 1 >= argc) {
+                printUsage(argv[0]);
+                return 1;
+            }
+            config.endgameBlocks = static_cast<std::size_t>(std::stoul(argv[argIndex + 1]));
             argIndex += 2;
+        } else if (arg == "--window") {
+            if (argIndex + 1 >= argc) {
+                printUsage(argv[0]);
+                return 1;
+            }
+            config.pipelineWindow = static_cast<std::size_t>(std::stoul(argv[argIndex + 1]));
+            argIndex += 2;
+        } else if (arg == "--server-threads") {
+            if (argIndex + 1 >= argc) {
+                printUsage(argv[0]);
+                return 1;
+            }
+            config.serverThreads = static_cast<std::size_t>(std::stoul(argv[argIndex + 1]));
+            argIndex += 2;
+        } else if (arg == "--io-backend") {
+            if (argIndex + 1 >= argc || !StorageBackend::parseKind(argv[argIndex + 1], config.ioBackend)) {
+                printUsage(argv[0]);
+                return 1;
+            }
+            argIndex += 2;
+        } else if (arg == "--max-frame") {
+            if (argIndex + 1 >= argc) {
+                printUsage(argv[0]);
+                return 1;
+            }
+            Protocol::setMaxFrameSize(static_cast<std::uint32_t>(std::stoul(argv[argIndex + 1])));
+            argIndex += 2;
+        } else if (arg == "--block-files") {
+            config.blockFiles = true;
+            argIndex += 1;
+        } else if (arg == "--journal-batch") {
+            if (argIndex + 1 >= argc) {
+                printUsage(argv[0]);
+                return 1;
+            }
+            config.journalBatch = static_cast<std::size_t>(std::stoul(argv[argIndex + 1]));
+            argIndex += 2;
+        } else if (arg == "--verify-resume") {
+            config.verifyOnResume = true;
+            argIndex += 1;
+        } else if (arg == "--verify-threads") {
+            if (argIndex + 1 >= argc) {
+                printUsage(argv[0]);
+                return 1;
+            }
+            config.verifyThreads = static_cast<unsigned>(std::stoul(argv[argIndex + 1]));
+            argIndex += 2;
+        } else if (arg == "--cache-mb") {
+            if (argIndex + 1 >= argc) {
+                printUsage(argv[0]);
+                return 1;
+            }
+            config.blockCacheBytes = static_cast<std::size_t>(std::stoul(argv[argIndex + 1])) * 1024 * 1024;
+            argIndex += 2;
+        } else if (arg == "--stats-interval") {
+            if (argIndex + 1 >= argc) {
+                printUsage(argv[0]);
+                return 1;
+            }
+            config.statsInterval = std::chrono::milliseconds(
+                static_cast<long long>(std::stod(argv[argIndex + 1]) * 1000));
+            argIndex += 2;
+        } else if (arg == "--log-level") {
+            Log::Level level;
+            if (argIndex + 1 >= argc || !Log::parseLevel(argv[argIndex + 1], level)) {
+                printUsage(argv[0]);
+                return 1;
+            }
+            Log::setLevel(level);
+            argIndex += 2;
+        } else if (arg == "--no-zero-copy") {
+            config.zeroCopyServe = false;
+            argIndex += 1;
         } else {
             break;
         }
@@ -79,12 +258,17 @@ int main(int argc, char* argv[]) {
         neighbors.push_back(neighbor);
     }
 
+    // sendfile não aceita MSG_NOSIGNAL: sem isto, um cliente que fecha a conexão
+    // com respostas pendentes (duplicatas do endgame) derrubaria o processo
+    std::signal(SIGPIPE, SIG_IGN);
+
     try {
-        Peer peer(myPort, neighbors, metadataPath);
+        Peer peer(myPort, neighbors, metadataPaths, config);
         peer.start();
     } catch (const std::exception& e) {
-        std::cerr << "Erro: " << e.what() << std::endl;
+        Log::error("Erro: ", e.what());
     }
+    Log::flush();
 
     return 0;
 }